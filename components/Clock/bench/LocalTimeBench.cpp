@@ -0,0 +1,88 @@
+/**
+ * @file LocalTimeBench.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <time.h>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "BenchUtil.hpp"
+#include "LocalTimeCache.hpp"
+
+namespace {
+using Bench::Clock;
+
+// Conversions per measurement unless --iterations is given
+constexpr uint32_t DefaultIterations = 2000000;
+// 2022-08-08T23:06:40Z, in EDT
+constexpr time_t Start = 1660000000;
+
+// Each time is converted twice, as the clock converts the same second from
+// the timer and the display
+time_t TimeAt(uint32_t aIteration) { return Start + aIteration / 2; }
+
+void Report(const char* aBenchmark, const Bench::Options& aOptions,
+            Clock::time_point aStart, Clock::time_point aEnd) {
+  const auto elapsed = Bench::ElapsedNs(aStart, aEnd);
+  Bench::JsonLine(aBenchmark)
+      .Field("conversions", aOptions.mIterations)
+      .Field("total_ns", elapsed)
+      .Field("ns_per_conversion",
+             static_cast<double>(elapsed) / aOptions.mIterations);
+}
+
+// What the clock did before LocalTimeCache
+void BenchLocaltime(const Bench::Options& aOptions) {
+  volatile uint32_t sink = 0;
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < aOptions.mIterations; ++i) {
+    const time_t time = TimeAt(i);
+    struct tm local;
+    localtime_r(&time, &local);
+    sink = sink + local.tm_min;
+  }
+  Report("localtime_r", aOptions, start, Clock::now());
+}
+
+void BenchCache(const Bench::Options& aOptions) {
+  volatile uint32_t sink = 0;
+  Clocks::LocalTimeCache cache;
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < aOptions.mIterations; ++i) {
+    sink = sink + cache.Convert(TimeAt(i)).mMinute;
+  }
+  Report("local_time_cache", aOptions, start, Clock::now());
+}
+}  // namespace
+
+/**
+ * Times LocalTimeCache::Convert against localtime_r over the same seconds in
+ * a zone with DST.
+ */
+int main(int argc, char** argv) {
+  Bench::Options options;
+  options.mIterations = DefaultIterations;
+  if (!Bench::ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+  setenv("TZ", "EST5EDT", 1);
+  tzset();
+
+  struct {
+    const char* mName;
+    void (*mRun)(const Bench::Options&);
+  } const benchmarks[] = {
+      {"localtime_r", &BenchLocaltime},
+      {"local_time_cache", &BenchCache},
+  };
+  for (const auto& benchmark : benchmarks) {
+    if (Bench::Selected(options, benchmark.mName)) {
+      benchmark.mRun(options);
+    }
+  }
+  return 0;
+}
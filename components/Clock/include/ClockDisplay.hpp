@@ -10,17 +10,23 @@
 #ifndef CLOCK_DISPLAY_H
 #define CLOCK_DISPLAY_H
 
-#include <time.h>
+#include "LocalTimeCache.hpp"
 
 namespace Clocks {
+/**
+ * @brief A display showing the time
+ *
+ * Implementations draw into a FrameBuffer mirroring the display memory and
+ * commit it, so only the bytes that changed are sent to the display.
+ */
 class ClockDisplay {
  public:
   /**
    * @brief Sets the Clock Display time
    *
-   * @param aTime the time to set the clock to
+   * @param aTime the local time to set the clock to
    */
-  virtual void SetTime(time_t aTime) = 0;
+  virtual void SetTime(const LocalTime& aTime) = 0;
 
   /**
    * @brief Clears the display
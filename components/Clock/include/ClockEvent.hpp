@@ -8,7 +8,12 @@
 #ifndef CLOCK_EVENT_H
 #define CLOCK_EVENT_H
 
+#include <time.h>
+
 #include "Event.hpp"
+#include "EventId.hpp"
+#include "EventPool.hpp"
+#include "LocalTimeCache.hpp"
 
 namespace Clocks {
 /**
@@ -17,8 +22,21 @@ namespace Clocks {
  */
 class ClockEvent : public Events::Event {
  public:
-  static auto constexpr Id = "ClockEvent";
-  ClockEvent(const time_t aNow) : Events::Event(Id), mNow(aNow) {}
+  static auto constexpr Id = "Clock/Time";
+  // Only the latest time matters to listeners
+  static constexpr Events::OverflowPolicy Overflow =
+      Events::OverflowPolicy::Conflate;
+
+  /**
+   * @brief Construct a new Clock Event
+   *
+   * @param aNow Seconds since the epoch
+   * @param aLocal aNow in the local timezone, so listeners need not convert it
+   */
+  ClockEvent(const time_t aNow, const LocalTime &aLocal)
+      : Events::Event(Events::GetEventId<ClockEvent>()),
+        mNow(aNow),
+        mLocal(aLocal) {}
   ~ClockEvent() = default;
 
   /**
@@ -26,10 +44,66 @@ class ClockEvent : public Events::Event {
    *
    * @return time_t
    */
-   time_t GetTime() { return mNow; }
+  time_t GetTime() const { return mNow; }
+
+  /**
+   * @brief Get the Time data in the local timezone
+   *
+   * @return const LocalTime&
+   */
+  const LocalTime &GetLocalTime() const { return mLocal; }
+
+  /**
+   * @brief Writes the time as a little-endian int64, followed by the UTC
+   * offset as a little-endian int32 and the DST flag
+   *
+   */
+  size_t Serialize(uint8_t *aBuffer, size_t aSize) const override {
+    if (aSize < PayloadSize) {
+      return 0;
+    }
+    const auto now = static_cast<uint64_t>(mNow);
+    for (size_t i = 0; i < TimeSize; ++i) {
+      aBuffer[i] = static_cast<uint8_t>(now >> (8 * i));
+    }
+    const auto offset = static_cast<uint32_t>(mLocal.mUtcOffset);
+    for (size_t i = 0; i < OffsetSize; ++i) {
+      aBuffer[TimeSize + i] = static_cast<uint8_t>(offset >> (8 * i));
+    }
+    aBuffer[TimeSize + OffsetSize] = mLocal.mDst ? 1 : 0;
+    return PayloadSize;
+  }
+
+  /**
+   * @brief Rebuilds a ClockEvent written by Serialize, for EventReplayer
+   *
+   */
+  static Events::EventPtr Deserialize(const uint8_t *aPayload, size_t aSize) {
+    if (aSize != PayloadSize) {
+      return nullptr;
+    }
+    uint64_t now = 0;
+    for (size_t i = 0; i < TimeSize; ++i) {
+      now |= static_cast<uint64_t>(aPayload[i]) << (8 * i);
+    }
+    uint32_t offset = 0;
+    for (size_t i = 0; i < OffsetSize; ++i) {
+      offset |= static_cast<uint32_t>(aPayload[TimeSize + i]) << (8 * i);
+    }
+    // Replay with the recorded offset rather than the current timezone
+    const auto time = static_cast<time_t>(now);
+    return Events::EventPool<ClockEvent>::Instance().Make(
+        time, LocalTimeCache::Breakdown(time, static_cast<int32_t>(offset),
+                                        aPayload[TimeSize + OffsetSize] != 0));
+  }
 
  private:
+  static constexpr size_t TimeSize = sizeof(uint64_t);
+  static constexpr size_t OffsetSize = sizeof(uint32_t);
+  static constexpr size_t PayloadSize = TimeSize + OffsetSize + 1;
+
   time_t mNow;
+  LocalTime mLocal;
 };
 }  // namespace Clocks
 
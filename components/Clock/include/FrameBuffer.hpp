@@ -0,0 +1,192 @@
+/**
+ * @file FrameBuffer.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace Clocks {
+/**
+ * @brief Outcome of FrameBuffer::Commit
+ *
+ */
+enum class CommitStatus : uint8_t {
+  // Every changed range was written
+  Committed,
+  // The back buffer matched the display, nothing was written
+  Unchanged,
+  // At least one range failed and will be rewritten by the next Commit
+  Failed,
+};
+
+/**
+ * @brief Frame buffer activity counters
+ *
+ */
+struct FrameStats {
+  uint32_t mCommitted;
+  uint32_t mUnchanged;
+  uint32_t mFailed;
+  // Ranges and data bytes written, excluding any addressing overhead
+  uint32_t mRanges;
+  uint32_t mBytes;
+  // Ranges and data bytes of the most recent frame written
+  uint32_t mFrameRanges;
+  uint32_t mFrameBytes;
+};
+
+/**
+ * @brief Double-buffered mirror of a display's memory
+ *
+ * Renderers draw into the back buffer. Commit compares it with the front
+ * buffer, which holds what the display shows, and hands only the changed byte
+ * ranges to the driver. Unchanged gaps of up to aMergeGap bytes between two
+ * ranges are written as part of one range, for displays where starting a new
+ * transfer costs more than rewriting a few bytes.
+ *
+ * Bytes whose display contents are unknown, at start up, after Invalidate or
+ * after a failed write, are stale and written by the next Commit even when
+ * they match the front buffer. Not thread safe, render and commit from one
+ * thread.
+ *
+ * @tparam TSize Bytes of display memory
+ */
+template <size_t TSize>
+class FrameBuffer {
+ public:
+  /**
+   * @brief Construct a new Frame Buffer with every byte stale
+   *
+   * @param aMergeGap Most unchanged bytes written to join two ranges
+   */
+  explicit FrameBuffer(size_t aMergeGap = 0) : mMergeGap(aMergeGap) {
+    mStale.set();
+  }
+
+  /**
+   * @brief Draws a byte into the back buffer
+   *
+   * @param aAddress Display memory address, ignored if out of range
+   * @param aValue Byte to draw
+   */
+  void Set(size_t aAddress, uint8_t aValue) {
+    if (aAddress < TSize) {
+      mBack[aAddress] = aValue;
+    }
+  }
+
+  /**
+   * @brief Get a byte of the back buffer
+   *
+   */
+  uint8_t Get(size_t aAddress) const { return mBack[aAddress]; }
+
+  /**
+   * @brief Clears the back buffer
+   *
+   */
+  void Clear() { std::fill(std::begin(mBack), std::end(mBack), 0); }
+
+  /**
+   * @brief Makes the next Commit rewrite the whole frame
+   *
+   */
+  void Invalidate() { mStale.set(); }
+
+  /**
+   * @brief Writes the changed ranges of the back buffer to the display
+   *
+   * @param aWrite Callable taking (size_t aAddress, const uint8_t* aData,
+   * size_t aSize) and returning whether the range was written
+   * @return CommitStatus
+   */
+  template <typename TWrite>
+  CommitStatus Commit(TWrite&& aWrite) {
+    size_t first = 0;
+    while (first < TSize && !IsDirty(first)) {
+      ++first;
+    }
+    if (first == TSize) {
+      ++mStats.mUnchanged;
+      return CommitStatus::Unchanged;
+    }
+
+    uint32_t ranges = 0;
+    uint32_t bytes = 0;
+    auto status = CommitStatus::Committed;
+    while (first < TSize) {
+      // Extend the range until more than mMergeGap clean bytes follow it
+      auto last = first;
+      for (auto next = first + 1; next < TSize && next - last <= mMergeGap + 1;
+           ++next) {
+        if (IsDirty(next)) {
+          last = next;
+        }
+      }
+
+      const auto size = last - first + 1;
+      if (aWrite(first, &mBack[first], size)) {
+        std::copy(&mBack[first], &mBack[last + 1], &mFront[first]);
+        for (auto i = first; i <= last; ++i) {
+          mStale.reset(i);
+        }
+      } else {
+        // Part of the range may have been written
+        for (auto i = first; i <= last; ++i) {
+          mStale.set(i);
+        }
+        status = CommitStatus::Failed;
+      }
+      ++ranges;
+      bytes += size;
+
+      first = last + 1;
+      while (first < TSize && !IsDirty(first)) {
+        ++first;
+      }
+    }
+
+    if (status == CommitStatus::Failed) {
+      ++mStats.mFailed;
+    } else {
+      ++mStats.mCommitted;
+    }
+    mStats.mRanges += ranges;
+    mStats.mBytes += bytes;
+    mStats.mFrameRanges = ranges;
+    mStats.mFrameBytes = bytes;
+    return status;
+  }
+
+  /**
+   * @brief Get the frame buffer activity counters
+   *
+   * @return FrameStats
+   */
+  FrameStats GetStats() const { return mStats; }
+
+ private:
+  bool IsDirty(size_t aAddress) const {
+    return mStale.test(aAddress) || mBack[aAddress] != mFront[aAddress];
+  }
+
+  const size_t mMergeGap;
+  uint8_t mBack[TSize]{};
+  uint8_t mFront[TSize]{};
+  std::bitset<TSize> mStale;
+  FrameStats mStats{};
+};
+}  // namespace Clocks
+
+#endif  // FRAME_BUFFER_H
@@ -12,10 +12,25 @@
 
 #include <time.h>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 #include "ClockDisplay.hpp"
+#include "FrameBuffer.hpp"
 #include "I2CBus.hpp"
 
 namespace Clocks {
+/**
+ * @brief Display bus activity counters, including the setup commands. Frame
+ * counts are in FrameStats.
+ *
+ */
+struct DisplayStats {
+  uint32_t mTransactions;
+  uint32_t mBytes;
+  uint32_t mFailed;
+};
 
 class HT16K33ClockDisplay : public ClockDisplay {
   enum Command : uint8_t {
@@ -39,6 +54,13 @@ class HT16K33ClockDisplay : public ClockDisplay {
     Num = 5,
   };
 
+  // Display RAM bytes wired to the four digits and the colon. Odd addresses
+  // drive the unused COM rows and are kept clear.
+  static constexpr uint8_t RamSize = DispPos::Four + 2;
+  // A transaction costs START, STOP, the device and RAM address bytes, more
+  // than rewriting two unchanged bytes between two changed ranges
+  static constexpr size_t MergeGap = 2;
+
   static constexpr uint8_t DigitPos[] = {
       DispPos::One,
       DispPos::Two,
@@ -71,9 +93,9 @@ class HT16K33ClockDisplay : public ClockDisplay {
   /**
    * @brief Set the Clock Display time
    *
-   * @param aTime the time to set the clock to
+   * @param aTime the local time to set the clock to
    */
-  void SetTime(time_t aTime) final;
+  void SetTime(const LocalTime& aTime) final;
 
   /**
    * @brief Clear the display
@@ -95,12 +117,46 @@ class HT16K33ClockDisplay : public ClockDisplay {
    */
   uint8_t GetBrightness();
 
+  /**
+   * @brief Get the display bus activity counters, from the thread updating
+   * the display
+   *
+   * @return DisplayStats
+   */
+  DisplayStats GetStats() const;
+
+  /**
+   * @brief Get the frame buffer counters, from the thread updating the
+   * display
+   *
+   * @return FrameStats
+   */
+  FrameStats GetFrameStats() const;
+
+  /**
+   * @brief Makes the next frame resend the oscillator, display and brightness
+   * setup and rewrite every byte, e.g. after a write that reported no result
+   * failed. Safe to call from any thread.
+   *
+   */
+  void Invalidate();
+
  private:
   void SetCharacter(DispPos aPos, uint8_t aCharacter);
   void SetDigit(DispPos aPos, uint8_t aNum);
+  void Flush();
+  bool Setup();
+  bool WriteCommand(uint8_t aCommand);
+  bool Write(const uint8_t* aData, size_t aSize);
+
   I2C::I2CBus& mDisplayBus;
-  uint8_t mCache[DispPos::Num]{0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  // Indexed by display RAM address
+  FrameBuffer<RamSize> mFrameBuffer{MergeGap};
+  std::atomic<bool> mInvalidated{false};
+  // The last setup failed, only accessed from the thread updating the display
+  bool mSetupPending = false;
   uint8_t mBrightness;
+  DisplayStats mStats{};
 };
 }  // namespace Clocks
 
@@ -0,0 +1,116 @@
+/**
+ * @file LocalTimeCache.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LOCAL_TIME_CACHE_H
+#define LOCAL_TIME_CACHE_H
+
+#include <time.h>
+
+#include <cstdint>
+
+namespace Clocks {
+/**
+ * @brief Broken-down local time
+ *
+ */
+struct LocalTime {
+  int32_t mYear;
+  // 1 to 12
+  uint8_t mMonth;
+  // 1 to 31
+  uint8_t mDay;
+  uint8_t mHour;
+  uint8_t mMinute;
+  uint8_t mSecond;
+  // 0 for Sunday to 6 for Saturday
+  uint8_t mWeekday;
+  bool mDst;
+  // Seconds east of UTC, including any DST shift
+  int32_t mUtcOffset;
+};
+
+/**
+ * @brief Local time activity counters
+ *
+ */
+struct LocalTimeStats {
+  uint32_t mConversions;
+  // Conversions that had to look up the UTC offset through localtime_r
+  uint32_t mOffsetLookups;
+  // Conversions that crossed into another local day
+  uint32_t mDateChanges;
+};
+
+/**
+ * @brief Converts UTC to local time without calling localtime per conversion
+ *
+ * The UTC offset of the current timezone is looked up once through
+ * localtime_r, together with the time of the next DST transition, and reused
+ * until then. The date is kept from the previous conversion while it stays
+ * on the same local day, so a conversion is usually a handful of integer
+ * operations.
+ *
+ * Not thread safe. Call Invalidate after changing the TZ environment
+ * variable.
+ */
+class LocalTimeCache {
+ public:
+  // How far ahead to look for the next DST transition. Zones without DST
+  // look up their offset again after this long.
+  static constexpr time_t LookAhead = 371 * 24 * 60 * 60;
+
+  /**
+   * @brief Converts a UTC time to local time in the current timezone
+   *
+   * @param aTime Seconds since the epoch
+   * @return LocalTime
+   */
+  LocalTime Convert(time_t aTime);
+
+  /**
+   * @brief Forgets the cached offset, e.g. after a timezone change
+   *
+   */
+  void Invalidate();
+
+  /**
+   * @brief Get the local time activity counters
+   *
+   * @return LocalTimeStats
+   */
+  LocalTimeStats GetStats() const { return mStats; }
+
+  /**
+   * @brief Breaks a UTC time down with a known UTC offset, without consulting
+   * the timezone
+   *
+   * @param aTime Seconds since the epoch
+   * @param aUtcOffset Seconds east of UTC
+   * @param aDst Whether aUtcOffset includes a DST shift
+   * @return LocalTime
+   */
+  static LocalTime Breakdown(time_t aTime, int32_t aUtcOffset, bool aDst);
+
+ private:
+  void LookUpOffset(time_t aTime);
+
+  int32_t mUtcOffset = 0;
+  bool mDst = false;
+  // mUtcOffset applies from mValidFrom up to, not including, mValidUntil
+  time_t mValidFrom = 0;
+  time_t mValidUntil = 0;
+  // Local day of the previous conversion in days since the epoch, and its
+  // date
+  int64_t mDay = INT64_MIN;
+  LocalTime mDate{};
+  LocalTimeStats mStats{};
+};
+}  // namespace Clocks
+
+#endif  // LOCAL_TIME_CACHE_H
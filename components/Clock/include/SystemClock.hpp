@@ -11,6 +11,10 @@
 
 #include <time.h>
 
+#include <mutex>
+
+#include "LocalTimeCache.hpp"
+
 namespace Clocks {
 class SystemClock {
  public:
@@ -24,6 +28,17 @@ class SystemClock {
    */
   time_t GetLocalTime();
 
+  /**
+   * @brief Converts a time to the local timezone
+   *
+   * Reuses the UTC offset and date of previous conversions, so converting the
+   * time on every clock update stays cheap. Safe to call from any thread.
+   *
+   * @param aTime Seconds since the epoch, e.g. from GetLocalTime
+   * @return LocalTime
+   */
+  LocalTime ToLocalTime(time_t aTime);
+
   /**
    * @brief Set the local timezone
    *
@@ -52,6 +67,8 @@ class SystemClock {
   void InitializeSntp();
   bool IsTimeInitialized();
   bool mIsTimeSet;
+  LocalTimeCache mLocalTimeCache;
+  std::mutex mLocalTimeMutex;
 };
 }  // namespace Clocks
 
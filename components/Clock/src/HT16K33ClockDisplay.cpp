@@ -9,27 +9,31 @@
 
 #include "HT16K33ClockDisplay.hpp"
 
+#include <algorithm>
+
+#ifdef ESP_PLATFORM
 #include "esp_log.h"
+#else
+// Host builds, e.g. driving the display over a simulated bus
+#define ESP_LOGI(aTag, ...)
+#define ESP_LOGD(aTag, ...)
+#endif
 
 static auto constexpr TAG = "HT16K33";
 
 namespace Clocks {
 HT16K33ClockDisplay::HT16K33ClockDisplay(I2C::I2CBus& aDisplayBus)
     : mDisplayBus(aDisplayBus), mBrightness(0xF) {
-  /* TODO add error handling here, throw exception if communication with HT16K33
-   * fails */
-
-  mDisplayBus.Write({Command::OscillatorOn});  // Clock oscillator on
-  mDisplayBus.Write({Command::DisplayOn});     // Clock display on
-  mDisplayBus.Write({static_cast<uint8_t>(
-      Command::DisplayBrightness | mBrightness)});  // Clock brightness full
+  // A chip that NACKs at boot is set up again by the first frame
+  if (!Setup()) {
+    mInvalidated.store(true, std::memory_order_relaxed);
+  }
   ClearDisplay();
 }
 
-void HT16K33ClockDisplay::SetTime(const time_t aTime) {
-  const auto tm = localtime(&aTime);
-  auto hours = tm->tm_hour % 12;  // TODO read preference for 12 or 24 hours
-  auto mins = tm->tm_min;
+void HT16K33ClockDisplay::SetTime(const LocalTime& aTime) {
+  auto hours = aTime.mHour % 12;  // TODO read preference for 12 or 24 hours
+  auto mins = aTime.mMinute;
 
   SetDigit(DispPos::Two, hours % 10);
   hours /= 10;
@@ -42,6 +46,7 @@ void HT16K33ClockDisplay::SetTime(const time_t aTime) {
   mins /= 10;
   SetDigit(DispPos::Three, mins);
   SetCharacter(DispPos::Colon, SpecialChar::ColonChar);
+  Flush();
 }
 
 void HT16K33ClockDisplay::ClearDisplay() {
@@ -50,36 +55,90 @@ void HT16K33ClockDisplay::ClearDisplay() {
   SetCharacter(DispPos::Colon, SpecialChar::ClearChar);
   SetCharacter(DispPos::Three, SpecialChar::ClearChar);
   SetCharacter(DispPos::Four, SpecialChar::ClearChar);
+  Flush();
 }
 
 void HT16K33ClockDisplay::SetBrightness(uint8_t aBrightness) {
   // Truncate to lower 4 bits
   aBrightness = aBrightness & 0xF;
   if (aBrightness != mBrightness) {
-    mBrightness = aBrightness;
-    ESP_LOGI(TAG, "Setting display brightness to %d", mBrightness);
-    mDisplayBus.Write(
-        {static_cast<uint8_t>(Command::DisplayBrightness | mBrightness)});
+    ESP_LOGI(TAG, "Setting display brightness to %d", aBrightness);
+    // Only remember the brightness once set, so the next call retries
+    if (WriteCommand(Command::DisplayBrightness | aBrightness)) {
+      mBrightness = aBrightness;
+    }
   }
 }
 
 uint8_t HT16K33ClockDisplay::GetBrightness() { return mBrightness; }
 
+DisplayStats HT16K33ClockDisplay::GetStats() const { return mStats; }
+
+FrameStats HT16K33ClockDisplay::GetFrameStats() const {
+  return mFrameBuffer.GetStats();
+}
+
+void HT16K33ClockDisplay::Invalidate() {
+  mInvalidated.store(true, std::memory_order_release);
+}
+
 void HT16K33ClockDisplay::SetCharacter(DispPos aPos, uint8_t aCharacter) {
-  if (mCache[aPos / 2] == aCharacter) {
-    return;
-  }
-  ESP_LOGI(TAG, "Writing 0x%X to position 0x%X", aCharacter, aPos);
-  mDisplayBus.Write({aPos, aCharacter});
-  mCache[aPos / 2] = aCharacter;
+  mFrameBuffer.Set(aPos, aCharacter);
 }
 
 void HT16K33ClockDisplay::SetDigit(DispPos aPos, uint8_t aNum) {
-  auto charData = NumericChar[aNum];
-  if (aPos == DispPos::Colon || aNum > sizeof(NumericChar) ||
-      mCache[aPos] == charData) {
+  if (aPos == DispPos::Colon || aNum >= sizeof(NumericChar)) {
     return;
   }
-  SetCharacter(aPos, charData);
+  SetCharacter(aPos, NumericChar[aNum]);
+}
+
+void HT16K33ClockDisplay::Flush() {
+  const bool invalidated =
+      mInvalidated.exchange(false, std::memory_order_acquire);
+  if (invalidated || mSetupPending) {
+    // The chip may have lost more than its display RAM, e.g. to a brown-out,
+    // and a queued write reports success before it reaches the bus. A failed
+    // setup is retried by the next frame, which rewrites only the ranges that
+    // failed.
+    mSetupPending = !Setup();
+  }
+  if (invalidated) {
+    mFrameBuffer.Invalidate();
+  }
+
+  // The HT16K33 auto-increments the RAM address after each byte, so each
+  // changed range is one transaction
+  mFrameBuffer.Commit(
+      [this](size_t aAddress, const uint8_t* aData, size_t aSize) {
+        // Start address followed by the data
+        uint8_t burst[RamSize + 1];
+        burst[0] = static_cast<uint8_t>(aAddress);
+        std::copy(aData, aData + aSize, &burst[1]);
+        ESP_LOGD(TAG, "Writing %u bytes from position 0x%X",
+                 static_cast<unsigned>(aSize), static_cast<unsigned>(aAddress));
+        return Write(burst, aSize + 1);
+      });
+}
+
+bool HT16K33ClockDisplay::Setup() {
+  return WriteCommand(Command::OscillatorOn) &&  // Clock oscillator on
+         WriteCommand(Command::DisplayOn) &&     // Clock display on
+         WriteCommand(Command::DisplayBrightness | mBrightness);
+}
+
+bool HT16K33ClockDisplay::WriteCommand(uint8_t aCommand) {
+  const uint8_t command[] = {aCommand};
+  return Write(command, sizeof(command));
+}
+
+bool HT16K33ClockDisplay::Write(const uint8_t* aData, size_t aSize) {
+  ++mStats.mTransactions;
+  mStats.mBytes += aSize;
+  if (!mDisplayBus.Write(aData, aSize)) {
+    ++mStats.mFailed;
+    return false;
+  }
+  return true;
 }
 }  // namespace Clocks
\ No newline at end of file
@@ -0,0 +1,142 @@
+/**
+ * @file LocalTimeCache.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "LocalTimeCache.hpp"
+
+namespace Clocks {
+namespace {
+constexpr int64_t SecondsPerDay = 24 * 60 * 60;
+// Step of the search for the next DST transition, shorter than the time
+// between two transitions
+constexpr time_t ProbeStep = 7 * SecondsPerDay;
+
+int64_t FloorDiv(int64_t aValue, int64_t aDivisor) {
+  return aValue / aDivisor - (aValue % aDivisor < 0 ? 1 : 0);
+}
+
+// Days since the epoch of a proleptic Gregorian date, see
+// http://howardhinnant.github.io/date_algorithms.html
+int64_t DaysFromCivil(int64_t aYear, int64_t aMonth, int64_t aDay) {
+  aYear -= aMonth <= 2;
+  const auto era = FloorDiv(aYear, 400);
+  const auto yearOfEra = aYear - era * 400;
+  const auto dayOfYear = (153 * (aMonth + (aMonth > 2 ? -3 : 9)) + 2) / 5 +
+                         aDay - 1;
+  const auto dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+// The date of a count of days since the epoch, inverse of DaysFromCivil
+void CivilFromDays(int64_t aDays, LocalTime& aDate) {
+  const auto shifted = aDays + 719468;
+  const auto era = FloorDiv(shifted, 146097);
+  const auto dayOfEra = shifted - era * 146097;
+  const auto yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+                          dayOfEra / 146096) /
+                         365;
+  const auto dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const auto monthIndex = (5 * dayOfYear + 2) / 153;
+  const auto month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  aDate.mYear = static_cast<int32_t>(yearOfEra + era * 400 + (month <= 2));
+  aDate.mMonth = static_cast<uint8_t>(month);
+  aDate.mDay = static_cast<uint8_t>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+  // The epoch was a Thursday
+  const auto weekday = (aDays + 4) % 7;
+  aDate.mWeekday = static_cast<uint8_t>(weekday < 0 ? weekday + 7 : weekday);
+}
+
+void SetTimeOfDay(int64_t aSeconds, LocalTime& aTime) {
+  aTime.mHour = static_cast<uint8_t>(aSeconds / 3600);
+  aTime.mMinute = static_cast<uint8_t>(aSeconds / 60 % 60);
+  aTime.mSecond = static_cast<uint8_t>(aSeconds % 60);
+}
+
+int32_t OffsetAt(time_t aTime, bool* aDst = nullptr) {
+  struct tm local;
+  localtime_r(&aTime, &local);
+  if (aDst) {
+    *aDst = local.tm_isdst > 0;
+  }
+  const auto localSeconds =
+      DaysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) *
+          SecondsPerDay +
+      local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+  return static_cast<int32_t>(localSeconds - aTime);
+}
+}  // namespace
+
+LocalTime LocalTimeCache::Convert(const time_t aTime) {
+  ++mStats.mConversions;
+  if (aTime < mValidFrom || aTime >= mValidUntil) {
+    LookUpOffset(aTime);
+  }
+
+  const auto local = static_cast<int64_t>(aTime) + mUtcOffset;
+  const auto day = FloorDiv(local, SecondsPerDay);
+  if (day != mDay) {
+    ++mStats.mDateChanges;
+    mDay = day;
+    CivilFromDays(day, mDate);
+  }
+
+  auto result = mDate;
+  SetTimeOfDay(local - day * SecondsPerDay, result);
+  result.mDst = mDst;
+  result.mUtcOffset = mUtcOffset;
+  return result;
+}
+
+void LocalTimeCache::Invalidate() {
+  mValidFrom = 0;
+  mValidUntil = 0;
+}
+
+LocalTime LocalTimeCache::Breakdown(const time_t aTime,
+                                    const int32_t aUtcOffset, const bool aDst) {
+  const auto local = static_cast<int64_t>(aTime) + aUtcOffset;
+  const auto day = FloorDiv(local, SecondsPerDay);
+  LocalTime result{};
+  CivilFromDays(day, result);
+  SetTimeOfDay(local - day * SecondsPerDay, result);
+  result.mDst = aDst;
+  result.mUtcOffset = aUtcOffset;
+  return result;
+}
+
+void LocalTimeCache::LookUpOffset(const time_t aTime) {
+  ++mStats.mOffsetLookups;
+  const auto offset = OffsetAt(aTime, &mDst);
+  mUtcOffset = offset;
+  mValidFrom = aTime;
+
+  // Walk forward a week at a time until the offset changes, then narrow the
+  // transition down to the second
+  time_t before = aTime;
+  time_t after = aTime + ProbeStep;
+  while (OffsetAt(after) == offset) {
+    if (after - aTime >= LookAhead) {
+      mValidUntil = after;
+      return;
+    }
+    before = after;
+    after += ProbeStep;
+  }
+  while (after - before > 1) {
+    const auto middle = before + (after - before) / 2;
+    if (OffsetAt(middle) == offset) {
+      before = middle;
+    } else {
+      after = middle;
+    }
+  }
+  mValidUntil = after;
+}
+}  // namespace Clocks
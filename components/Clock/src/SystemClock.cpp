@@ -35,9 +35,16 @@ time_t SystemClock::GetLocalTime() {
   return now;
 }
 
+LocalTime SystemClock::ToLocalTime(const time_t aTime) {
+  std::lock_guard<std::mutex> lock(mLocalTimeMutex);
+  return mLocalTimeCache.Convert(aTime);
+}
+
 void SystemClock::SetTz(const char* aTzString) {
+  std::lock_guard<std::mutex> lock(mLocalTimeMutex);
   setenv("TZ", aTzString, 1);
   tzset();
+  mLocalTimeCache.Invalidate();
 }
 
 bool SystemClock::IsTimeSet() { return mIsTimeSet; }
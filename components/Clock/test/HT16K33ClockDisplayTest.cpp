@@ -0,0 +1,186 @@
+/**
+ * @file HT16K33ClockDisplayTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "HT16K33ClockDisplay.hpp"
+#include "LocalTimeCache.hpp"
+#include "SimulatedHT16K33.hpp"
+#include "SimulatedI2CBus.hpp"
+
+namespace {
+// Segment patterns of the digits and the colon, see HT16K33ClockDisplay
+constexpr uint8_t Zero = 0x3F;
+constexpr uint8_t One = 0x06;
+constexpr uint8_t Five = 0x6D;
+constexpr uint8_t Nine = 0x6F;
+constexpr uint8_t Colon = 0x02;
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char* aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+
+Clocks::LocalTime At(uint8_t aHour, uint8_t aMinute) {
+  Clocks::LocalTime time{};
+  time.mHour = aHour;
+  time.mMinute = aMinute;
+  return time;
+}
+
+// Compares the display RAM with the digits and colon it should show, the
+// odd addresses drive unused rows and must stay clear
+bool Shows(const I2C::SimulatedHT16K33& aChip, uint8_t aFirst,
+           uint8_t aSecond, uint8_t aColon, uint8_t aThird, uint8_t aFourth) {
+  const uint8_t expected[I2C::SimulatedHT16K33::DisplayRamSize] = {
+      aFirst, 0, aSecond, 0, aColon, 0, aThird, 0, aFourth};
+  const auto ram = aChip.GetDisplayRam();
+  for (size_t i = 0; i < I2C::SimulatedHT16K33::DisplayRamSize; ++i) {
+    if (ram[i] != expected[i]) {
+      std::printf("display RAM 0x%02zX is 0x%02X, expected 0x%02X\n", i,
+                  ram[i], expected[i]);
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+/**
+ * Drives HT16K33ClockDisplay over the simulated bus and checks what the chip
+ * ends up showing and what it cost on the wire.
+ */
+int main() {
+  I2C::SimulatedHT16K33 chip;
+  I2C::SimulatedI2CBus bus(chip);
+  Clocks::HT16K33ClockDisplay display(bus);
+
+  Check(chip.IsOscillatorOn(), "oscillator is off after construction");
+  Check(chip.IsDisplayOn(), "display is off after construction");
+  Check(chip.GetBrightness() == 0xF, "brightness is not full");
+  Check(Shows(chip, 0, 0, 0, 0, 0), "display is not clear");
+  // Oscillator, display setup and dimming, then the whole cleared frame
+  auto stats = bus.GetStats();
+  Check(stats.mTransactions == 4, "setup took other than four transactions");
+
+  display.SetTime(At(22, 59));
+  Check(Shows(chip, One, Zero, Colon, Five, Nine), "10:59 not shown");
+
+  // The hour rollover changes the second digit and both minute digits. The
+  // minutes are one range, the hour digit too far from them to merge.
+  bus.ResetStats();
+  display.SetTime(At(23, 0));
+  Check(Shows(chip, One, One, Colon, Zero, Zero), "11:00 not shown");
+  stats = bus.GetStats();
+  std::printf("10:59 to 11:00: %" PRIu32 " transactions, %" PRIu32
+              " bytes, %" PRIu64 " bus clocks\n",
+              stats.mTransactions, stats.mBytes, stats.mBits);
+  Check(stats.mTransactions == 2, "rollover took other than two transactions");
+  Check(stats.mBytes == 8, "rollover wrote other than eight bytes");
+  Check(stats.mBits == 76, "rollover took other than 76 bus clocks");
+  const auto frame = display.GetFrameStats();
+  Check(frame.mFrameRanges == 2, "rollover wrote other than two ranges");
+  Check(frame.mFrameBytes == 4, "rollover wrote other than four RAM bytes");
+
+  // The same frame as a single burst spanning the hour and minute digits,
+  // replayed on a second chip, costs more than the two ranges
+  I2C::SimulatedHT16K33 spanChip;
+  I2C::SimulatedI2CBus spanBus(spanChip);
+  uint8_t span[8] = {2};
+  std::copy(chip.GetDisplayRam() + 2, chip.GetDisplayRam() + 9, &span[1]);
+  spanBus.Write(span, sizeof(span));
+  const auto spanStats = spanBus.GetStats();
+  std::printf("10:59 to 11:00 as one burst: %" PRIu32 " transactions, %" PRIu32
+              " bytes, %" PRIu64 " bus clocks\n",
+              spanStats.mTransactions, spanStats.mBytes, spanStats.mBits);
+  Check(spanStats.mBits == 83, "spanning burst took other than 83 bus clocks");
+  Check(stats.mBits < spanStats.mBits, "two ranges cost more than one burst");
+
+  bus.ResetStats();
+  display.SetTime(At(23, 0));
+  Check(bus.GetStats().mTransactions == 0, "an unchanged frame was written");
+
+  display.SetTime(At(0, 5));
+  Check(Shows(chip, 0, Zero, Colon, Zero, Five), " 0:05 not shown");
+
+  display.SetBrightness(0x3);
+  Check(chip.GetBrightness() == 0x3, "brightness not applied");
+
+  // A chip that lost its setup, e.g. to a brown-out, while every write
+  // appeared to succeed: oscillator off, display off, dimmest, blank RAM
+  const uint8_t reset[][2] = {{0x20}, {0x80}, {0xE0}};
+  for (const auto& command : reset) {
+    bus.Write(command, 1);
+  }
+  const uint8_t blank[I2C::SimulatedHT16K33::DisplayRamSize + 1] = {};
+  bus.Write(blank, sizeof(blank));
+  display.Invalidate();
+  display.SetTime(At(0, 5));
+  Check(chip.IsOscillatorOn(), "Invalidate did not restart the oscillator");
+  Check(chip.IsDisplayOn(), "Invalidate did not turn the display on");
+  Check(chip.GetBrightness() == 0x3, "Invalidate did not restore brightness");
+  Check(Shows(chip, 0, Zero, Colon, Zero, Five), "Invalidate lost the frame");
+
+  // The oscillator write of the repair NACKs. The frame is still rewritten,
+  // and the next frame resends only the setup.
+  for (const auto& command : reset) {
+    bus.Write(command, 1);
+  }
+  bus.FailNextWrites(1);
+  display.Invalidate();
+  display.SetTime(At(0, 5));
+  Check(!chip.IsOscillatorOn(), "the failed oscillator write reached the chip");
+  Check(Shows(chip, 0, Zero, Colon, Zero, Five), "frame lost with the setup");
+  bus.ResetStats();
+  display.SetTime(At(0, 5));
+  Check(chip.IsOscillatorOn(), "failed setup not retried by the next frame");
+  Check(chip.IsDisplayOn(), "display not turned on by the retried setup");
+  Check(chip.GetBrightness() == 0x3, "brightness not restored by the retry");
+  Check(bus.GetStats().mTransactions == 3,
+        "setup retry took other than the three setup commands");
+
+  // A RAM burst NACKs: the hour digit, the first range, stays 0 while the
+  // minutes land. The next frame rewrites only that range.
+  bus.FailNextWrites(1);
+  display.SetTime(At(1, 10));
+  Check(Shows(chip, 0, Zero, Colon, One, Zero), "failed burst not isolated");
+  bus.ResetStats();
+  display.SetTime(At(1, 10));
+  Check(Shows(chip, 0, One, Colon, One, Zero), "failed burst not rewritten");
+  Check(bus.GetStats().mTransactions == 1,
+        "burst retry rewrote other than the failed range");
+  Check(bus.GetStats().mBytes == 3,
+        "burst retry wrote other than one digit");
+
+  display.ClearDisplay();
+  Check(Shows(chip, 0, 0, 0, 0, 0), "display not cleared");
+
+  Check(chip.GetInvalidCommands() == 0, "the chip received invalid commands");
+  Check(display.GetStats().mFailed == 2, "not exactly the two writes failed");
+
+  // The chip NACKs the first setup write at boot. The first frame, drawn by
+  // the constructor, sets it up again.
+  I2C::SimulatedHT16K33 bootChip;
+  I2C::SimulatedI2CBus bootBus(bootChip);
+  bootBus.FailNextWrites(1);
+  Clocks::HT16K33ClockDisplay bootDisplay(bootBus);
+  Check(bootChip.IsOscillatorOn(), "failed boot setup left the oscillator off");
+  Check(bootChip.IsDisplayOn(), "failed boot setup left the display off");
+  Check(bootChip.GetBrightness() == 0xF, "failed boot setup left it dimmed");
+  bootDisplay.SetTime(At(22, 59));
+  Check(Shows(bootChip, One, Zero, Colon, Five, Nine),
+        "10:59 not shown after a failed boot setup");
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
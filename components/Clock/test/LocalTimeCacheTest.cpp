@@ -0,0 +1,95 @@
+/**
+ * @file LocalTimeCacheTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <time.h>
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "LocalTimeCache.hpp"
+
+namespace {
+// 2022-01-01T00:00:00Z
+constexpr time_t Start2022 = 1640995200;
+constexpr time_t Day = 24 * 60 * 60;
+// Mismatches printed per timezone, the rest are only counted
+constexpr int MaxReported = 3;
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char* aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+
+bool Matches(const Clocks::LocalTime& aLocal, const struct tm& aExpected) {
+  return aLocal.mYear == aExpected.tm_year + 1900 &&
+         aLocal.mMonth == aExpected.tm_mon + 1 &&
+         aLocal.mDay == aExpected.tm_mday &&
+         aLocal.mHour == aExpected.tm_hour &&
+         aLocal.mMinute == aExpected.tm_min &&
+         aLocal.mSecond == aExpected.tm_sec &&
+         aLocal.mWeekday == aExpected.tm_wday &&
+         aLocal.mDst == (aExpected.tm_isdst > 0) &&
+         aLocal.mUtcOffset == aExpected.tm_gmtoff;
+}
+
+// Converts every aStep seconds from aFrom up to aTo in aZone with both
+// LocalTimeCache and localtime_r. A step prime to the length of a day lands
+// on a different second of the day each time, and close to every DST
+// transition.
+void CheckZone(const char* aZone, time_t aFrom, time_t aTo, time_t aStep) {
+  setenv("TZ", aZone, 1);
+  tzset();
+  Clocks::LocalTimeCache cache;
+  int mismatches = 0;
+  for (time_t time = aFrom; time < aTo; time += aStep) {
+    const auto local = cache.Convert(time);
+    struct tm expected;
+    localtime_r(&time, &expected);
+    if (!Matches(local, expected) && mismatches++ < MaxReported) {
+      std::printf("%s at %lld: %04" PRId32
+                  "-%02u-%02u %02u:%02u:%02u, expected "
+                  "%04d-%02d-%02d %02d:%02d:%02d\n",
+                  aZone, static_cast<long long>(time), local.mYear,
+                  local.mMonth, local.mDay, local.mHour, local.mMinute,
+                  local.mSecond, expected.tm_year + 1900,
+                  expected.tm_mon + 1, expected.tm_mday, expected.tm_hour,
+                  expected.tm_min, expected.tm_sec);
+    }
+  }
+  const auto stats = cache.GetStats();
+  std::printf("%s: %" PRIu32 " conversions, %" PRIu32
+              " offset lookups, %" PRIu32 " date changes, %d mismatches\n",
+              aZone, stats.mConversions, stats.mOffsetLookups,
+              stats.mDateChanges, mismatches);
+  Check(mismatches == 0, "LocalTimeCache disagrees with localtime_r");
+  // The cache only pays off if most conversions skip the lookup
+  Check(stats.mOffsetLookups * 100 < stats.mConversions,
+        "more than one conversion in a hundred looked up the offset");
+}
+}  // namespace
+
+/**
+ * Compares LocalTimeCache with localtime_r across DST transitions, a zone
+ * south of the equator, a zone without DST and a half hour offset.
+ */
+int main() {
+  CheckZone("EST5EDT", Start2022, Start2022 + 3 * 366 * Day, 37);
+  CheckZone("EST5EDT,M3.2.0,M11.1.0", Start2022, Start2022 + 2 * 366 * Day,
+            61);
+  // Either side of the epoch
+  CheckZone("UTC0", -800 * Day, 800 * Day, 997);
+  CheckZone("NZST-12NZDT,M9.5.0,M4.1.0/3", Start2022,
+            Start2022 + 2 * 366 * Day, 59);
+  CheckZone("IST-5:30", Start2022, Start2022 + 30 * Day, 13);
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file ClockReplay.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "ClockEvent.hpp"
+#include "EventDispatcher.hpp"
+#include "EventQueue.hpp"
+#include "EventReplayer.hpp"
+#include "HT16K33ClockDisplay.hpp"
+#include "SimulatedHT16K33.hpp"
+#include "SimulatedI2CBus.hpp"
+
+namespace {
+struct Options {
+  const char* mPath = nullptr;
+  Events::ReplaySpeed mSpeed = Events::ReplaySpeed::Recorded;
+  bool mDisplay = false;
+};
+
+bool ParseOptions(int aArgc, char** aArgv, Options& aOptions) {
+  for (int i = 1; i < aArgc; ++i) {
+    if (std::strcmp(aArgv[i], "--fast") == 0) {
+      aOptions.mSpeed = Events::ReplaySpeed::AsFastAsPossible;
+    } else if (std::strcmp(aArgv[i], "--display") == 0) {
+      aOptions.mDisplay = true;
+    } else if (aArgv[i][0] != '-' && !aOptions.mPath) {
+      aOptions.mPath = aArgv[i];
+    } else {
+      aOptions.mPath = nullptr;
+      break;
+    }
+  }
+  if (!aOptions.mPath) {
+    std::fprintf(stderr, "usage: %s [--fast] [--display] stream.evr\n",
+                 aArgv[0]);
+    return false;
+  }
+  return true;
+}
+
+bool ReadFile(const char* aPath, std::vector<uint8_t>& aData) {
+  auto file = std::fopen(aPath, "rb");
+  if (!file) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t read = 0;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    aData.insert(aData.end(), chunk, chunk + read);
+  }
+  const auto ok = !std::ferror(file);
+  std::fclose(file);
+  return ok;
+}
+}  // namespace
+
+/**
+ * Replays a ClockEvent recording, e.g. one flushed from the device's
+ * recorder partition, on the host:
+ *
+ *   clock_replay [--fast] [--display] stream.evr
+ *
+ * Each ClockEvent is printed as it is delivered, or drawn on a simulated
+ * HT16K33 with --display. The replay outcome is printed last as a single
+ * line JSON object.
+ */
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+  std::vector<uint8_t> stream;
+  if (!ReadFile(options.mPath, stream)) {
+    std::fprintf(stderr, "cannot read %s\n", options.mPath);
+    return 1;
+  }
+
+  Events::EventQueue queue;
+  Events::EventDispatcher dispatcher(queue);
+  I2C::SimulatedHT16K33 chip;
+  I2C::SimulatedI2CBus bus(chip);
+  Clocks::HT16K33ClockDisplay display(bus);
+  std::atomic<uint32_t> delivered{0};
+  dispatcher.Listen<Clocks::ClockEvent>(
+      [&](const Clocks::ClockEvent& aEvent) {
+        const auto& local = aEvent.GetLocalTime();
+        if (options.mDisplay) {
+          display.SetTime(local);
+        } else {
+          std::printf("%lld %02d:%02d:%02d dst=%d\n",
+                      static_cast<long long>(aEvent.GetTime()), local.mHour,
+                      local.mMinute, local.mSecond, local.mDst ? 1 : 0);
+        }
+        delivered.fetch_add(1, std::memory_order_relaxed);
+      });
+  std::thread consumer(&Events::EventQueue::RunLoop, &queue);
+
+  Events::EventReplayer replayer(dispatcher);
+  replayer.AddDecoder<Clocks::ClockEvent>();
+  Events::ReplayStats stats{};
+  const auto ok =
+      replayer.Replay(stream.data(), stream.size(), options.mSpeed, stats);
+  while (queue.Size() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  queue.Stop();
+  consumer.join();
+
+  std::printf("{\"complete\":%s,\"records\":%" PRIu32
+              ",\"dispatched\":%" PRIu32 ",\"undecoded\":%" PRIu32
+              ",\"dropped\":%" PRIu32 ",\"delivered\":%" PRIu32
+              ",\"recorded_us\":%" PRIu64 ",\"replay_us\":%" PRIu64,
+              ok ? "true" : "false", stats.mRecords, stats.mDispatched,
+              stats.mUndecoded, stats.mDropped, delivered.load(),
+              stats.mRecordedUs, stats.mReplayUs);
+  if (options.mDisplay) {
+    const auto busStats = bus.GetStats();
+    std::printf(",\"display_ram\":\"");
+    for (size_t i = 0; i < I2C::SimulatedHT16K33::DisplayRamSize; ++i) {
+      std::printf("%02x", chip.GetDisplayRam()[i]);
+    }
+    std::printf("\",\"bus_transactions\":%" PRIu32 ",\"bus_bytes\":%" PRIu32
+                ",\"bus_bits\":%" PRIu64,
+                busStats.mTransactions, busStats.mBytes, busStats.mBits);
+  }
+  std::printf("}\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file InplaceFunction.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef INPLACE_FUNCTION_H
+#define INPLACE_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Common {
+template <typename TSignature, size_t Capacity>
+class InplaceFunction;
+
+/**
+ * @brief Fixed-size replacement for std::function that never allocates
+ *
+ * The callable is stored inside the object itself. A callable larger than
+ * Capacity bytes is rejected at compile time instead of falling back to the
+ * heap, so registering a handler can never allocate or fail at runtime.
+ *
+ * @tparam TReturn Return type of the call signature
+ * @tparam TArgs Argument types of the call signature
+ * @tparam Capacity Bytes reserved for the callable and its captures
+ */
+template <typename TReturn, typename... TArgs, size_t Capacity>
+class InplaceFunction<TReturn(TArgs...), Capacity> {
+ public:
+  InplaceFunction() = default;
+  InplaceFunction(std::nullptr_t) {}
+
+  template <typename TCallable,
+            typename = std::enable_if_t<!std::is_same<
+                std::decay_t<TCallable>, InplaceFunction>::value>>
+  InplaceFunction(TCallable &&aCallable) {
+    typedef std::decay_t<TCallable> T;
+    static_assert(sizeof(T) <= Capacity,
+                  "Callable does not fit in this InplaceFunction, capture "
+                  "less state or raise the capacity");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Callable is over-aligned for InplaceFunction");
+    static_assert(std::is_copy_constructible<T>::value,
+                  "InplaceFunction requires a copyable callable");
+    // A null function pointer leaves the InplaceFunction empty, as it does
+    // std::function
+    if constexpr (std::is_pointer<T>::value ||
+                  std::is_member_pointer<T>::value) {
+      if (aCallable == nullptr) {
+        return;
+      }
+    }
+    new (&mStorage) T(std::forward<TCallable>(aCallable));
+    mOps = &OpsFor<T>::Table;
+  }
+
+  InplaceFunction(const InplaceFunction &aOther) : mOps(aOther.mOps) {
+    if (mOps) {
+      mOps->mCopy(&mStorage, &aOther.mStorage);
+    }
+  }
+
+  InplaceFunction(InplaceFunction &&aOther) noexcept : mOps(aOther.mOps) {
+    if (mOps) {
+      mOps->mMove(&mStorage, &aOther.mStorage);
+      aOther.Reset();
+    }
+  }
+
+  ~InplaceFunction() { Reset(); }
+
+  InplaceFunction &operator=(const InplaceFunction &aOther) {
+    if (this != &aOther) {
+      Reset();
+      if (aOther.mOps) {
+        aOther.mOps->mCopy(&mStorage, &aOther.mStorage);
+        mOps = aOther.mOps;
+      }
+    }
+    return *this;
+  }
+
+  InplaceFunction &operator=(InplaceFunction &&aOther) noexcept {
+    if (this != &aOther) {
+      Reset();
+      if (aOther.mOps) {
+        aOther.mOps->mMove(&mStorage, &aOther.mStorage);
+        mOps = aOther.mOps;
+        aOther.Reset();
+      }
+    }
+    return *this;
+  }
+
+  InplaceFunction &operator=(std::nullptr_t) {
+    Reset();
+    return *this;
+  }
+
+  /**
+   * @brief Calls the stored callable. Must not be called when empty.
+   *
+   */
+  TReturn operator()(TArgs... aArgs) const {
+    return mOps->mInvoke(&mStorage, std::forward<TArgs>(aArgs)...);
+  }
+
+  explicit operator bool() const { return mOps != nullptr; }
+
+ private:
+  // One table of plain function pointers per callable type instead of a
+  // virtual base, so the storage holds only the callable
+  struct Ops {
+    TReturn (*mInvoke)(void *, TArgs &&...);
+    void (*mCopy)(void *, const void *);
+    void (*mMove)(void *, void *);
+    void (*mDestroy)(void *);
+  };
+
+  template <typename T>
+  struct OpsFor {
+    static TReturn Invoke(void *aStorage, TArgs &&...aArgs) {
+      return (*static_cast<T *>(aStorage))(std::forward<TArgs>(aArgs)...);
+    }
+    static void Copy(void *aDest, const void *aSource) {
+      new (aDest) T(*static_cast<const T *>(aSource));
+    }
+    static void Move(void *aDest, void *aSource) {
+      new (aDest) T(std::move(*static_cast<T *>(aSource)));
+    }
+    static void Destroy(void *aStorage) { static_cast<T *>(aStorage)->~T(); }
+
+    static constexpr Ops Table{&Invoke, &Copy, &Move, &Destroy};
+  };
+
+  void Reset() {
+    if (mOps) {
+      mOps->mDestroy(&mStorage);
+      mOps = nullptr;
+    }
+  }
+
+  mutable std::aligned_storage_t<Capacity, alignof(std::max_align_t)>
+      mStorage;
+  const Ops *mOps = nullptr;
+};
+}  // namespace Common
+
+#endif  // INPLACE_FUNCTION_H
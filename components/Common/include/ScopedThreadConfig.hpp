@@ -0,0 +1,68 @@
+/**
+ * @file ScopedThreadConfig.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SCOPED_THREAD_CONFIG_H
+#define SCOPED_THREAD_CONFIG_H
+
+#ifdef ESP_PLATFORM
+#include "esp_pthread.h"
+#endif
+
+namespace Common {
+/**
+ * @brief Names and pins the std::threads the calling thread creates while in
+ * scope
+ *
+ * esp_pthread_set_cfg applies to every later std::thread of the calling
+ * thread, so the previous config is restored on destruction. Does nothing on
+ * the host.
+ */
+class ScopedThreadConfig {
+ public:
+  static constexpr int NoCoreAffinity = -1;
+
+  /**
+   * @brief Construct a new Scoped Thread Config
+   *
+   * @param aName Thread name, must outlive the threads created
+   * @param aCore CPU core to pin the threads to, or NoCoreAffinity
+   */
+  explicit ScopedThreadConfig(const char *aName,
+                              int aCore = NoCoreAffinity) {
+#ifdef ESP_PLATFORM
+    if (esp_pthread_get_cfg(&mPrevious) != ESP_OK) {
+      mPrevious = esp_pthread_get_default_config();
+    }
+    auto config = esp_pthread_get_default_config();
+    config.thread_name = aName;
+    if (aCore != NoCoreAffinity) {
+      config.pin_to_core = aCore;
+    }
+    esp_pthread_set_cfg(&config);
+#else
+    (void)aName;
+    (void)aCore;
+#endif
+  }
+
+  ~ScopedThreadConfig() {
+#ifdef ESP_PLATFORM
+    esp_pthread_set_cfg(&mPrevious);
+#endif
+  }
+
+  ScopedThreadConfig(const ScopedThreadConfig &) = delete;
+  ScopedThreadConfig &operator=(const ScopedThreadConfig &) = delete;
+
+ private:
+#ifdef ESP_PLATFORM
+  esp_pthread_cfg_t mPrevious;
+#endif
+};
+}  // namespace Common
+
+#endif  // SCOPED_THREAD_CONFIG_H
@@ -0,0 +1,55 @@
+/**
+ * @file InplaceFunctionTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "InplaceFunction.hpp"
+
+namespace {
+typedef Common::InplaceFunction<int(int), 2 * sizeof(void *)> Function;
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char *aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+
+int Twice(int aValue) { return 2 * aValue; }
+}  // namespace
+
+/**
+ * Checks which InplaceFunctions are empty and that callables survive copies
+ * and moves.
+ */
+int main() {
+  Check(!Function(), "default constructed function is not empty");
+  Check(!Function(nullptr), "nullptr function is not empty");
+
+  int (*null)(int) = nullptr;
+  Check(!Function(null), "null function pointer is not empty");
+
+  Function pointer(&Twice);
+  Check(static_cast<bool>(pointer), "function pointer is empty");
+  Check(pointer(21) == 42, "function pointer returned the wrong value");
+
+  const int offset = 1;
+  Function lambda([offset](int aValue) { return aValue + offset; });
+  Function copy(lambda);
+  Check(copy(1) == 2, "copied lambda returned the wrong value");
+  Function moved(std::move(lambda));
+  Check(!lambda, "moved-from function is not empty");
+  Check(moved(2) == 3, "moved lambda returned the wrong value");
+
+  moved = nullptr;
+  Check(!moved, "function assigned nullptr is not empty");
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
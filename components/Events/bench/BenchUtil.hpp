@@ -0,0 +1,155 @@
+/**
+ * @file BenchUtil.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace Bench {
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief Command line options shared by the host benchmarks
+ *
+ */
+struct Options {
+  // Events, calls or iterations per measurement
+  uint32_t mIterations = 100000;
+  // Only run benchmarks whose name starts with this prefix
+  const char *mFilter = "";
+};
+
+/**
+ * @brief Parses "[--iterations N] [filter]"
+ *
+ * @return true the arguments are valid
+ * @return false usage was printed to stderr
+ */
+inline bool ParseOptions(int aArgc, char **aArgv, Options &aOptions) {
+  for (int i = 1; i < aArgc; ++i) {
+    if (std::strcmp(aArgv[i], "--iterations") == 0 && i + 1 < aArgc) {
+      aOptions.mIterations =
+          static_cast<uint32_t>(std::strtoul(aArgv[++i], nullptr, 10));
+    } else if (aArgv[i][0] != '-') {
+      aOptions.mFilter = aArgv[i];
+    } else {
+      std::fprintf(stderr, "usage: %s [--iterations N] [filter]\n",
+                   aArgv[0]);
+      return false;
+    }
+  }
+  if (aOptions.mIterations == 0) {
+    aOptions.mIterations = 1;
+  }
+  return true;
+}
+
+/**
+ * @brief Whether a benchmark is selected by the filter
+ *
+ */
+inline bool Selected(const Options &aOptions, const char *aBenchmark) {
+  return std::strncmp(aBenchmark, aOptions.mFilter,
+                      std::strlen(aOptions.mFilter)) == 0;
+}
+
+/**
+ * @brief Nanoseconds between two time points
+ *
+ */
+inline uint64_t ElapsedNs(Clock::time_point aStart, Clock::time_point aEnd) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(aEnd - aStart)
+          .count());
+}
+
+/**
+ * @brief Latency distribution of a set of samples
+ *
+ */
+struct Percentiles {
+  uint64_t mP50;
+  uint64_t mP90;
+  uint64_t mP99;
+  uint64_t mMax;
+};
+
+/**
+ * @brief Summarizes samples, reordering them
+ *
+ */
+inline Percentiles Summarize(std::vector<uint64_t> &aSamples) {
+  if (aSamples.empty()) {
+    return Percentiles{};
+  }
+  std::sort(aSamples.begin(), aSamples.end());
+  const auto at = [&aSamples](size_t aPercent) {
+    return aSamples[(aSamples.size() - 1) * aPercent / 100];
+  };
+  return Percentiles{at(50), at(90), at(99), aSamples.back()};
+}
+
+/**
+ * @brief Writes one benchmark result as a single line JSON object on stdout
+ *
+ * Fields are written in the order they are added, so the output of two
+ * builds can be diffed line by line.
+ */
+class JsonLine {
+ public:
+  explicit JsonLine(const char *aBenchmark) {
+    std::printf("{\"benchmark\":\"%s\"", aBenchmark);
+  }
+  ~JsonLine() {
+    std::printf("}\n");
+    std::fflush(stdout);
+  }
+
+  JsonLine(const JsonLine &) = delete;
+  JsonLine &operator=(const JsonLine &) = delete;
+
+  JsonLine &Field(const char *aName, const char *aValue) {
+    std::printf(",\"%s\":\"%s\"", aName, aValue);
+    return *this;
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<std::is_integral<T>::value>>
+  JsonLine &Field(const char *aName, T aValue) {
+    std::printf(",\"%s\":%" PRIu64, aName, static_cast<uint64_t>(aValue));
+    return *this;
+  }
+
+  JsonLine &Field(const char *aName, double aValue) {
+    std::printf(",\"%s\":%.1f", aName, aValue);
+    return *this;
+  }
+
+  /**
+   * @brief Adds name_p50, name_p90, name_p99 and name_max fields
+   *
+   */
+  JsonLine &Field(const char *aName, const Percentiles &aValue) {
+    std::printf(",\"%s_p50\":%" PRIu64 ",\"%s_p90\":%" PRIu64
+                ",\"%s_p99\":%" PRIu64 ",\"%s_max\":%" PRIu64,
+                aName, aValue.mP50, aName, aValue.mP90, aName, aValue.mP99,
+                aName, aValue.mMax);
+    return *this;
+  }
+};
+}  // namespace Bench
+
+#endif  // BENCH_UTIL_H
@@ -0,0 +1,103 @@
+/**
+ * @file CallbackBench.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef CALLBACK_BENCH_H
+#define CALLBACK_BENCH_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "Event.hpp"
+#include "EventId.hpp"
+#include "EventListener.hpp"
+
+namespace Bench {
+/**
+ * @brief Event passed to the benchmarked callbacks
+ *
+ */
+class CallbackEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Bench/Callback";
+
+  CallbackEvent() : Events::Event(Events::GetEventId<CallbackEvent>()) {}
+};
+
+/**
+ * @brief Registers, copies and calls a listener-sized callable through
+ * TFunction and writes the cost of each as a JsonLine
+ *
+ * @tparam TFunction Callback type, e.g. Events::EventCallback
+ * @param aFunction Name of TFunction in the output
+ * @param aRegistrations Callables registered and copied, each held twice
+ * @param aCalls Calls of one registered callable
+ */
+template <typename TFunction>
+void RunCallback(const char *aFunction, uint32_t aRegistrations,
+                 uint32_t aCalls) {
+  // Three pointers, as captured by a typical listener. std::function only
+  // stores two inline with libstdc++, so this one goes to the heap.
+  uint64_t a = 1;
+  uint64_t b = 2;
+  uint64_t c = 3;
+  std::vector<TFunction> registered;
+  registered.reserve(aRegistrations);
+  const auto registerStart = Clock::now();
+  for (uint32_t i = 0; i < aRegistrations; ++i) {
+    registered.emplace_back([&a, &b, &c](const Events::Event &) {
+      a += b + c;
+    });
+  }
+  const auto registerNs = ElapsedNs(registerStart, Clock::now());
+
+  // Listen and Unlisten copy every listener of an Event ID into the new
+  // snapshot
+  const auto copyStart = Clock::now();
+  std::vector<TFunction> copies(registered);
+  const auto copyNs = ElapsedNs(copyStart, Clock::now());
+
+  const CallbackEvent event;
+  const auto &callback = copies.front();
+  const auto callStart = Clock::now();
+  for (uint32_t i = 0; i < aCalls; ++i) {
+    callback(event);
+  }
+  const auto callNs = ElapsedNs(callStart, Clock::now());
+
+  JsonLine("callback")
+      .Field("function", aFunction)
+      .Field("registrations", aRegistrations)
+      .Field("calls", aCalls)
+      .Field("register_ns", static_cast<double>(registerNs) / aRegistrations)
+      .Field("copy_ns", static_cast<double>(copyNs) / aRegistrations)
+      .Field("call_ns", static_cast<double>(callNs) / aCalls)
+      .Field("result", a);
+}
+
+/**
+ * @brief Compares EventCallback with the std::function it replaced
+ *
+ * Shared by the host benchmarks and the target run enabled by
+ * CONFIG_EVENTS_CALLBACK_BENCH.
+ *
+ * @param aRegistrations Callables registered and copied per function type
+ * @param aCalls Calls per function type
+ */
+inline void RunCallbacks(uint32_t aRegistrations, uint32_t aCalls) {
+  if (aRegistrations == 0 || aCalls == 0) {
+    return;
+  }
+  RunCallback<Events::EventCallback>("inplace_function", aRegistrations,
+                                     aCalls);
+  RunCallback<std::function<void(const Events::Event &)>>(
+      "std_function", aRegistrations, aCalls);
+}
+}  // namespace Bench
+
+#endif  // CALLBACK_BENCH_H
@@ -0,0 +1,542 @@
+/**
+ * @file EventsBench.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BenchUtil.hpp"
+#include "CallbackBench.hpp"
+#include "Event.hpp"
+#include "EventDispatcher.hpp"
+#include "EventExecutor.hpp"
+#include "EventId.hpp"
+#include "EventQueue.hpp"
+#include "EventTrace.hpp"
+
+namespace {
+using Bench::Clock;
+
+// Big enough that producers mostly measure the queue, not the pool fallback
+constexpr size_t QueueCapacity = 128;
+constexpr uint32_t MaxLatencySamples = 20000;
+// Each polled sample takes about half the poll period
+constexpr uint32_t MaxPolledLatencySamples = 200;
+// Period of the event loop app_main ran before RunLoop
+constexpr auto PollPeriod = std::chrono::milliseconds(10);
+// Gap between latency samples so the consumer is asleep when each Event is
+// dispatched, as it is on the device
+constexpr auto LatencyGap = std::chrono::microseconds(50);
+// A listener blocked this long, like one waiting on an I2C transaction
+constexpr auto SlowListenerTime = std::chrono::milliseconds(2);
+// Gap between isolation samples, long enough for the slow listener to finish
+constexpr auto IsolationGap = std::chrono::milliseconds(3);
+constexpr uint32_t MaxIsolationSamples = 200;
+
+class BenchEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Bench/Event";
+  static constexpr size_t PoolSize = 2 * QueueCapacity;
+  // Producers outrunning the consumer wait instead of losing Events
+  static constexpr Events::OverflowPolicy Overflow =
+      Events::OverflowPolicy::Block;
+  static constexpr uint32_t BlockTimeoutMs = 1000;
+
+  explicit BenchEvent(Clock::time_point aStamp)
+      : Events::Event(Events::GetEventId<BenchEvent>()), mStamp(aStamp) {}
+
+  Clock::time_point GetStamp() const { return mStamp; }
+
+ private:
+  Clock::time_point mStamp;
+};
+
+/**
+ * @brief An Event Queue with its dispatcher and a consumer thread
+ *
+ */
+class Pipeline {
+ public:
+  Pipeline() : mQueue(QueueCapacity), mDispatcher(mQueue) {}
+  ~Pipeline() { Stop(); }
+
+  Events::EventDispatcher &GetDispatcher() { return mDispatcher; }
+  Events::EventQueue &GetQueue() { return mQueue; }
+
+  void Start() {
+    mConsumer = std::thread(&Events::EventQueue::RunLoop, &mQueue);
+  }
+
+  /**
+   * @brief Starts a consumer popping one Event every PollPeriod, as app_main
+   * did before RunLoop
+   *
+   */
+  void StartPolling() {
+    mConsumer = std::thread([this] {
+      while (!mPollStopped.load()) {
+        mQueue.Pop();
+        std::this_thread::sleep_for(PollPeriod);
+      }
+    });
+  }
+
+  void Stop() {
+    if (mConsumer.joinable()) {
+      mPollStopped.store(true);
+      mQueue.Stop();
+      mConsumer.join();
+    }
+  }
+
+ private:
+  Events::EventQueue mQueue;
+  Events::EventDispatcher mDispatcher;
+  std::atomic<bool> mPollStopped{false};
+  std::thread mConsumer;
+};
+
+/**
+ * @brief The Event Queue before the lock-free ring buffer, kept as the
+ * baseline of queue_contention
+ *
+ * One unbounded std::queue behind a mutex, with the consumer polling Pop and
+ * running the callbacks while it holds the lock.
+ */
+class MutexEventQueue {
+ public:
+  void Push(Events::EventPtr aEvent, Events::ListenerSnapshot aListeners) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.emplace(std::move(aEvent), std::move(aListeners));
+  }
+
+  bool Pop() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mQueue.empty()) {
+      return false;
+    }
+    const auto entry = std::move(mQueue.front());
+    mQueue.pop();
+    for (const auto &listener : *entry.second) {
+      listener.mCallback(*entry.first);
+    }
+    return true;
+  }
+
+ private:
+  std::queue<std::pair<Events::EventPtr, Events::ListenerSnapshot>> mQueue;
+  std::mutex mMutex;
+};
+
+struct RunResult {
+  uint64_t mElapsedNs;
+  uint32_t mDispatched;
+  uint32_t mDropped;
+};
+
+// Dispatches aEvents split over aProducers threads to aListeners listeners
+// and waits until every queued Event was delivered
+RunResult RunProducers(size_t aProducers, size_t aListeners,
+                       uint32_t aEvents) {
+  Pipeline pipeline;
+  std::atomic<uint64_t> calls{0};
+  for (size_t i = 0; i < aListeners; ++i) {
+    pipeline.GetDispatcher().Listen<BenchEvent>(
+        [&calls](const BenchEvent &) {
+          calls.fetch_add(1, std::memory_order_relaxed);
+        });
+  }
+  pipeline.Start();
+
+  std::atomic<bool> go{false};
+  std::atomic<uint32_t> dispatched{0};
+  std::atomic<uint32_t> dropped{0};
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < aProducers; ++p) {
+    const auto count = aEvents / aProducers + (p < aEvents % aProducers);
+    producers.emplace_back([&, count] {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      uint32_t ok = 0;
+      uint32_t lost = 0;
+      for (size_t i = 0; i < count; ++i) {
+        const auto status =
+            pipeline.GetDispatcher().Dispatch<BenchEvent>(Clock::now());
+        if (status == Events::DispatchStatus::Queued) {
+          ++ok;
+        } else {
+          ++lost;
+        }
+      }
+      dispatched.fetch_add(ok);
+      dropped.fetch_add(lost);
+    });
+  }
+
+  const auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  const auto expected = static_cast<uint64_t>(dispatched.load()) * aListeners;
+  while (calls.load(std::memory_order_relaxed) < expected) {
+    std::this_thread::yield();
+  }
+  const auto end = Clock::now();
+  pipeline.Stop();
+  return RunResult{Bench::ElapsedNs(start, end), dispatched.load(),
+                   dropped.load()};
+}
+
+void WriteRun(const char *aBenchmark, size_t aProducers, size_t aListeners,
+              const RunResult &aResult) {
+  const auto seconds = aResult.mElapsedNs / 1e9;
+  const auto delivered = aResult.mDispatched > 0 ? aResult.mDispatched : 1;
+  Bench::JsonLine(aBenchmark)
+      .Field("producers", aProducers)
+      .Field("listeners", aListeners)
+      .Field("events", aResult.mDispatched)
+      .Field("dropped", aResult.mDropped)
+      .Field("elapsed_ns", aResult.mElapsedNs)
+      .Field("events_per_s", aResult.mDispatched / seconds)
+      .Field("ns_per_event", static_cast<double>(aResult.mElapsedNs) /
+                                 delivered)
+      .Field("ns_per_callback",
+             static_cast<double>(aResult.mElapsedNs) /
+                 (static_cast<double>(delivered) * aListeners));
+}
+
+// Busy-waits, standing in for a listener doing real work such as an I2C
+// write
+void Spin(uint32_t aNs) {
+  const auto end = Clock::now() + std::chrono::nanoseconds(aNs);
+  while (Clock::now() < end) {
+  }
+}
+
+// Pushes aEvents split over aProducers threads straight into an Event Queue
+// or the mutex baseline, timing every push. Producers push as fast as they
+// can, or every aGap when it is not zero.
+template <typename TQueue>
+void RunQueueContention(const char *aQueueName, size_t aProducers,
+                        uint32_t aListenerNs, std::chrono::microseconds aGap,
+                        uint32_t aEvents) {
+  std::atomic<uint32_t> calls{0};
+  Events::Listener listener;
+  listener.mId = 1;
+  listener.mCallback = [&calls, aListenerNs](const Events::Event &) {
+    Spin(aListenerNs);
+    calls.fetch_add(1, std::memory_order_relaxed);
+  };
+  const Events::ListenerSnapshot listeners =
+      std::make_shared<const Events::ListenerList>(1, listener);
+
+  TQueue queue;
+  std::atomic<bool> stopped{false};
+  std::thread consumer([&queue, &stopped] { queue.Consume(stopped); });
+
+  std::atomic<bool> go{false};
+  std::vector<std::vector<uint64_t>> pushNs(aProducers);
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < aProducers; ++p) {
+    const auto count = aEvents / aProducers + (p < aEvents % aProducers);
+    pushNs[p].reserve(count);
+    producers.emplace_back([&, p, count] {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      auto next = Clock::now();
+      for (size_t i = 0; i < count; ++i) {
+        if (aGap.count() > 0) {
+          next += aGap;
+          std::this_thread::sleep_until(next);
+        }
+        auto event = Events::EventPool<BenchEvent>::Instance().Make(
+            Clock::now());
+        const auto start = Clock::now();
+        queue.Push(std::move(event), listeners);
+        pushNs[p].push_back(Bench::ElapsedNs(start, Clock::now()));
+      }
+    });
+  }
+
+  const auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  while (calls.load(std::memory_order_relaxed) < aEvents) {
+    std::this_thread::yield();
+  }
+  const auto elapsedNs = Bench::ElapsedNs(start, Clock::now());
+  stopped.store(true);
+  queue.Wake();
+  consumer.join();
+
+  std::vector<uint64_t> samples;
+  for (const auto &producerNs : pushNs) {
+    samples.insert(samples.end(), producerNs.begin(), producerNs.end());
+  }
+  Bench::JsonLine("queue_contention")
+      .Field("queue", aQueueName)
+      .Field("producers", aProducers)
+      .Field("listener_ns", aListenerNs)
+      .Field("gap_us", aGap.count())
+      .Field("events", aEvents)
+      .Field("elapsed_ns", elapsedNs)
+      .Field("events_per_s", aEvents / (elapsedNs / 1e9))
+      .Field("push_ns", Bench::Summarize(samples));
+}
+
+// The lock-free Event Queue, consumed by RunLoop
+struct RingQueue {
+  Events::EventQueue mQueue{QueueCapacity};
+
+  void Push(Events::EventPtr aEvent, Events::ListenerSnapshot aListeners) {
+    Events::DispatchOptions options;
+    options.mOverflow = Events::OverflowPolicy::Block;
+    options.mBlockTimeout = std::chrono::milliseconds(1000);
+    mQueue.Push(std::move(aEvent), std::move(aListeners), options);
+  }
+  void Consume(std::atomic<bool> &) { mQueue.RunLoop(); }
+  void Wake() { mQueue.Stop(); }
+};
+
+// The mutex baseline, consumed by polling Pop without the 10 ms sleep of the
+// old event loop so only the queues are compared
+struct LockedQueue {
+  MutexEventQueue mQueue;
+
+  void Push(Events::EventPtr aEvent, Events::ListenerSnapshot aListeners) {
+    mQueue.Push(std::move(aEvent), std::move(aListeners));
+  }
+  void Consume(std::atomic<bool> &aStopped) {
+    while (!aStopped.load()) {
+      if (!mQueue.Pop()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  void Wake() {}
+};
+
+// One producer, one listener: the cost of moving an Event through the
+// pipeline when nothing else competes for it
+void BenchThroughput(const Bench::Options &aOptions) {
+  WriteRun("throughput", 1, 1, RunProducers(1, 1, aOptions.mIterations));
+}
+
+// Time from Dispatch to the listener being called, one Event in flight at a
+// time, with the consumer woken by producers or polling
+void RunLatency(bool aPolling, uint32_t aSamples) {
+  Pipeline pipeline;
+  const auto samples = aSamples;
+  std::vector<uint64_t> latencies;
+  latencies.reserve(samples);
+  std::atomic<uint32_t> delivered{0};
+  pipeline.GetDispatcher().Listen<BenchEvent>(
+      [&](const BenchEvent &aEvent) {
+        latencies.push_back(Bench::ElapsedNs(aEvent.GetStamp(), Clock::now()));
+        delivered.fetch_add(1, std::memory_order_release);
+      });
+  if (aPolling) {
+    pipeline.StartPolling();
+  } else {
+    pipeline.Start();
+  }
+
+  // Events reach a polling consumer at any point of its period
+  std::minstd_rand random;
+  std::uniform_int_distribution<int64_t> phase(
+      0, std::chrono::microseconds(PollPeriod).count());
+  for (uint32_t i = 0; i < samples; ++i) {
+    std::this_thread::sleep_for(
+        aPolling ? LatencyGap + std::chrono::microseconds(phase(random))
+                 : LatencyGap);
+    pipeline.GetDispatcher().Dispatch<BenchEvent>(Clock::now());
+    while (delivered.load(std::memory_order_acquire) <= i) {
+      std::this_thread::yield();
+    }
+  }
+  pipeline.Stop();
+  // The Event Queue's own counters, measured from Push to Invoke
+  const auto stats = pipeline.GetQueue().GetLatencyStats();
+  Bench::JsonLine("latency")
+      .Field("consumer", aPolling ? "poll_10ms" : "run_loop")
+      .Field("samples", latencies.size())
+      .Field("latency_ns", Bench::Summarize(latencies))
+      .Field("queue_mean_us",
+             stats.mCount > 0 ? static_cast<double>(stats.mTotalUs) /
+                                    stats.mCount
+                              : 0.0)
+      .Field("queue_max_us", stats.mMaxUs);
+}
+
+// Dispatch-to-callback latency before and after the wakeup-driven RunLoop
+void BenchLatency(const Bench::Options &aOptions) {
+  RunLatency(true, aOptions.mIterations < MaxPolledLatencySamples
+                       ? aOptions.mIterations
+                       : MaxPolledLatencySamples);
+  RunLatency(false, aOptions.mIterations < MaxLatencySamples
+                        ? aOptions.mIterations
+                        : MaxLatencySamples);
+}
+
+// Cost per Event and per Callback as the number of listeners grows
+void BenchFanOut(const Bench::Options &aOptions) {
+  for (const size_t listeners : {1, 4, 16, 64}) {
+    WriteRun("fanout", 1, listeners,
+             RunProducers(1, listeners, aOptions.mIterations));
+  }
+}
+
+// Producers dispatching concurrently into one Event Queue
+void BenchContention(const Bench::Options &aOptions) {
+  for (const size_t producers : {1, 2, 4, 8}) {
+    WriteRun("contention", producers, 1,
+             RunProducers(producers, 1, aOptions.mIterations));
+  }
+}
+
+// Time from Dispatch to a fast listener being called while a slow listener
+// of the same Event blocks, with both on the Event Queue thread or on
+// executor workers. aExecutor is null for the Event Queue thread.
+void RunIsolation(const char *aPlacement, Events::EventExecutor *aExecutor,
+                  int aSlowWorker, int aFastWorker, uint32_t aSamples) {
+  Pipeline pipeline;
+  std::vector<uint64_t> latencies;
+  latencies.reserve(aSamples);
+  std::atomic<uint32_t> delivered{0};
+
+  Events::ListenerOptions slow;
+  slow.mExecutor = aExecutor;
+  slow.mWorker = aSlowWorker;
+  // Registered first so it runs first when both share a thread
+  pipeline.GetDispatcher().Listen<BenchEvent>(
+      [](const BenchEvent &) { std::this_thread::sleep_for(SlowListenerTime); },
+      slow);
+  Events::ListenerOptions fast;
+  fast.mExecutor = aExecutor;
+  fast.mWorker = aFastWorker;
+  pipeline.GetDispatcher().Listen<BenchEvent>(
+      [&](const BenchEvent &aEvent) {
+        latencies.push_back(Bench::ElapsedNs(aEvent.GetStamp(), Clock::now()));
+        delivered.fetch_add(1, std::memory_order_release);
+      },
+      fast);
+  pipeline.Start();
+
+  for (uint32_t i = 0; i < aSamples; ++i) {
+    std::this_thread::sleep_for(IsolationGap);
+    pipeline.GetDispatcher().Dispatch<BenchEvent>(Clock::now());
+    while (delivered.load(std::memory_order_acquire) <= i) {
+      std::this_thread::yield();
+    }
+  }
+  pipeline.Stop();
+  Bench::JsonLine("isolation")
+      .Field("placement", aPlacement)
+      .Field("slow_listener_us",
+             std::chrono::microseconds(SlowListenerTime).count())
+      .Field("samples", latencies.size())
+      .Field("fast_latency_ns", Bench::Summarize(latencies));
+}
+
+// Whether an EventExecutor keeps a slow listener from delaying the others
+void BenchIsolation(const Bench::Options &aOptions) {
+  const auto samples = aOptions.mIterations < MaxIsolationSamples
+                           ? aOptions.mIterations
+                           : MaxIsolationSamples;
+  RunIsolation("queue_thread", nullptr, Events::ListenerOptions::AnyWorker,
+               Events::ListenerOptions::AnyWorker, samples);
+  {
+    Events::EventExecutor executor(2);
+    RunIsolation("pinned_workers", &executor, 0, 1, samples);
+  }
+  {
+    Events::EventExecutor executor(2);
+    RunIsolation("any_worker", &executor, Events::ListenerOptions::AnyWorker,
+                 Events::ListenerOptions::AnyWorker, samples);
+  }
+}
+
+// EventCallback against the std::function it replaced
+void BenchCallback(const Bench::Options &aOptions) {
+  Bench::RunCallbacks(aOptions.mIterations, aOptions.mIterations);
+}
+
+// Producers pushing into the lock-free Event Queue and into the mutex queue
+// it replaced. Unpaced producers with an empty listener measure raw queue
+// throughput. Paced producers with a slow listener, busy about half the time,
+// show what a listener like the display's I2C write costs the producers: with
+// the mutex queue every push arriving during a callback waits for it.
+void BenchQueueContention(const Bench::Options &aOptions) {
+  constexpr uint32_t SlowListenerNs = 20000;
+  for (const size_t producers : {1, 2, 4, 8}) {
+    RunQueueContention<RingQueue>("mpsc_ring", producers, 0,
+                                  std::chrono::microseconds(0),
+                                  aOptions.mIterations);
+    RunQueueContention<LockedQueue>("mutex", producers, 0,
+                                    std::chrono::microseconds(0),
+                                    aOptions.mIterations);
+  }
+  const auto events = aOptions.mIterations / 100 + 1;
+  for (const size_t producers : {1, 2, 4, 8}) {
+    const auto gap =
+        std::chrono::microseconds(2 * SlowListenerNs / 1000 * producers);
+    RunQueueContention<RingQueue>("mpsc_ring", producers, SlowListenerNs, gap,
+                                  events);
+    RunQueueContention<LockedQueue>("mutex", producers, SlowListenerNs, gap,
+                                    events);
+  }
+}
+}  // namespace
+
+/**
+ * Host benchmarks of the Events pipeline. Prints one JSON object per line:
+ *
+ *   events_bench [--iterations N] [filter] > results.jsonl
+ *
+ * Run the same build configuration before and after a change and diff the
+ * two result files.
+ */
+int main(int argc, char **argv) {
+  Bench::Options options;
+  if (!Bench::ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+
+  struct {
+    const char *mName;
+    void (*mRun)(const Bench::Options &);
+  } const benchmarks[] = {
+      {"throughput", &BenchThroughput},
+      {"latency", &BenchLatency},
+      {"fanout", &BenchFanOut},
+      {"contention", &BenchContention},
+      {"queue_contention", &BenchQueueContention},
+      {"isolation", &BenchIsolation},
+      {"callback", &BenchCallback},
+  };
+  for (const auto &benchmark : benchmarks) {
+    if (Bench::Selected(options, benchmark.mName)) {
+      benchmark.mRun(options);
+    }
+  }
+#ifdef EVENTS_TRACING
+  // Per stage histograms of everything the benchmarks dispatched
+  Events::Trace::WriteJson(stdout);
+#endif
+  return 0;
+}
@@ -8,22 +8,85 @@
 #ifndef EVENT_H
 #define EVENT_H
 
-#include <optional>
-#include <string>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "EventId.hpp"
 
 namespace Events {
+/**
+ * @brief Event Queue lane an Event is queued in. Lower values are drained
+ * first.
+ */
+enum class EventPriority : uint8_t {
+  High,
+  Normal,
+  Low,
+  Count,
+};
+
+/**
+ * @brief What happens to a dispatched Event when its Event Queue lane is full
+ *
+ */
+enum class OverflowPolicy : uint8_t {
+  // Wait up to BlockTimeoutMs for the consumer to make room
+  Block,
+  // Drop the Event being dispatched
+  DropNewest,
+  // Drop the oldest pending Event of the lane to make room
+  DropOldest,
+  // Replace a pending Event of the same class and conflation key, so at most
+  // one Event per key is ever pending. Dropped if the lane is full when no
+  // Event is pending.
+  Conflate,
+};
 
 /**
  * @brief Base class for Events
  *
- * Specific Event types should implement this class and provide a static Event
- * ID in the constructor. Derived Event types may implement additional member
- * functions for accessing Event data.
+ * Specific Event types should implement this class, provide a static Event
+ * ID string named Id and pass GetEventId<Derived>() to the constructor.
+ * Derived Event types may implement additional member functions for accessing
+ * Event data.
  *
  */
 class Event {
  public:
-  Event(const char *aEventId) : mEventId(aEventId) {}
+  /**
+   * @brief Number of Events of a derived class that can be pending at once
+   * without heap allocation. Derived classes may shadow this constant.
+   */
+  static constexpr size_t PoolSize = 8;
+
+  /**
+   * @brief How Events of a derived class are queued when their lane is full.
+   * With OverflowPolicy::Conflate a newly dispatched Event always replaces a
+   * pending Event of the same class and conflation key instead of queueing
+   * behind it. Derived classes may shadow this constant.
+   */
+  static constexpr OverflowPolicy Overflow = OverflowPolicy::DropNewest;
+
+  /**
+   * @brief Longest time a producer waits for room with OverflowPolicy::Block.
+   * Derived classes may shadow this constant.
+   */
+  static constexpr uint32_t BlockTimeoutMs = 10;
+
+  /**
+   * @brief Priority lane Events of a derived class are queued in. Derived
+   * classes may shadow this constant.
+   */
+  static constexpr EventPriority Priority = EventPriority::Normal;
+
+  /**
+   * @brief Time after dispatch by which Events of a derived class should be
+   * invoked, or 0 for no deadline. Derived classes may shadow this constant.
+   */
+  static constexpr uint32_t DeadlineMs = 0;
+
+  Event(EventId aEventId) : mEventId(aEventId) {}
   virtual ~Event() = default;
 
   /**
@@ -31,12 +94,48 @@ class Event {
    *
    * Used by the Event Dispatcher to match Callbacks with Events.
    *
+   * @return EventId
+   */
+  EventId GetId() const { return mEventId; }
+
+  /**
+   * @brief Returns the Event ID string
+   *
    * @return const char*
    */
-  const char *GetId() { return mEventId; }
+  const char *GetName() const { return GetEventName(mEventId); }
+
+  /**
+   * @brief Returns the key conflating Events are matched on
+   *
+   * Only pending Events with the same key replace each other. Derived classes
+   * may shadow this function to conflate per key, e.g. per sensor.
+   *
+   * @return uint16_t
+   */
+  uint16_t GetConflationKey() const { return 0; }
+
+  /**
+   * @brief Writes the Event data for EventRecorder
+   *
+   * Derived classes override this to have their data recorded, and provide a
+   * matching static Deserialize for EventReplayer.
+   *
+   * @param aBuffer Destination for the payload
+   * @param aSize Capacity of aBuffer
+   * @return size_t Number of bytes written, at most aSize
+   */
+  virtual size_t Serialize(uint8_t *aBuffer, size_t aSize) const {
+    (void)aBuffer;
+    (void)aSize;
+    return 0;
+  }
 
  private:
-  const char *mEventId;
+  friend class EventRef;
+
+  EventId mEventId;
+  mutable std::atomic<uint16_t> mRefCount{0};
 };
 }  // namespace Events
 
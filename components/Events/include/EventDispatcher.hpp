@@ -8,20 +8,40 @@
 #ifndef EVENT_DISPATCHER_H
 #define EVENT_DISPATCHER_H
 
-#include <functional>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Event.hpp"
+#include "EventExecutor.hpp"
+#include "EventId.hpp"
+#include "EventListener.hpp"
+#include "EventPool.hpp"
 #include "EventQueue.hpp"
+#include "EventRecorder.hpp"
+#include "TopicTrie.hpp"
 
 namespace Events {
 /**
  * @brief Provides functionality for Dispatching Events to the Event Queue and
  * registering callbacks for Events
  *
+ * Listeners are kept in immutable per Event ID snapshots that are published
+ * atomically on every change, so dispatching never waits for a registration
+ * to finish. The shared_ptr atomics are not lock-free with GCC's libstdc++:
+ * each load or store takes one of a small pool of spinlocks, held only
+ * while the pointer is copied or swapped.
+ *
+ * Listeners may subscribe to wildcard patterns of hierarchical Event IDs, see
+ * TopicTrie. Patterns are resolved against every interned Event ID when
+ * listeners change and folded into the per Event ID snapshots, so wildcards
+ * cost Dispatch no string matching. Event IDs interned later are resolved the
+ * first time they are dispatched.
  */
 class EventDispatcher {
  public:
@@ -32,30 +52,214 @@ class EventDispatcher {
    * @brief Dispatches an Event to the Event Queue
    *
    * This thread-safe function adds an Event to the Event queue to be triggered.
+   * Every listener, including those registered with ListenerOptions::mInline,
+   * is invoked on the thread processing the Event Queue.
    *
    * @param aEvent Event to be dispatched. Generally this should be a derived
    * Event that Listeners will expect for a given event type.
+   * @param aOptions Priority lane, deadline and overflow policy of the Event.
+   * OverflowPolicy::Conflate conflates on the default key of zero.
+   * @return DispatchStatus whether the Event was queued, conflated or dropped
+   */
+  DispatchStatus Dispatch(EventPtr aEvent,
+                          const DispatchOptions &aOptions = DispatchOptions());
+
+  /**
+   * @brief Dispatches a heap allocated Event to the Event Queue
+   *
+   * @param aEvent Event to be dispatched
+   * @return DispatchStatus whether the Event was queued or dropped
+   */
+  DispatchStatus Dispatch(std::unique_ptr<Event> aEvent);
+
+  /**
+   * @brief Constructs and dispatches an Event to the Event Queue
+   *
+   * The Event is constructed in the EventPool of TEvent instead of on the
+   * heap. The Event is queued in the TEvent::Priority lane with a deadline of
+   * TEvent::DeadlineMs, if set, and TEvent::Overflow decides what happens when
+   * the lane is full.
+   *
+   * @tparam TEvent Derived Event class to construct
+   * @param aArgs Arguments forwarded to the TEvent constructor
+   * @return DispatchStatus whether the Event was queued, conflated or dropped
    */
-  void Dispatch(std::unique_ptr<Event> aEvent);
+  template <typename TEvent, typename... TArgs>
+  DispatchStatus Dispatch(TArgs &&...aArgs) {
+    return DispatchTyped<TEvent>(false, std::forward<TArgs>(aArgs)...);
+  }
+
+  /**
+   * @brief Dispatches an Event, running inline listeners on the calling thread
+   *
+   * Listeners registered with ListenerOptions::mInline are invoked before this
+   * function returns, the remaining listeners get the Event through the Event
+   * Queue as usual. A DispatchNow from inside an inline Callback is queued for
+   * every listener instead, so inline Callbacks never nest.
+   *
+   * @param aEvent Event to be dispatched
+   * @param aOptions Priority lane, deadline and overflow policy of the queued
+   * Event
+   * @return DispatchStatus Delivered if only inline listeners were invoked,
+   * otherwise the status of queueing the Event
+   */
+  DispatchStatus DispatchNow(
+      EventPtr aEvent, const DispatchOptions &aOptions = DispatchOptions());
+
+  /**
+   * @brief Constructs an Event in the EventPool of TEvent and dispatches it
+   * with DispatchNow
+   *
+   * @tparam TEvent Derived Event class to construct
+   * @param aArgs Arguments forwarded to the TEvent constructor
+   * @return DispatchStatus see DispatchNow
+   */
+  template <typename TEvent, typename... TArgs>
+  DispatchStatus DispatchNow(TArgs &&...aArgs) {
+    return DispatchTyped<TEvent>(true, std::forward<TArgs>(aArgs)...);
+  }
 
   /**
    * @brief Registers a listener with the Event Queue to trigger when Events are
    * dispatched
    *
    * @param aEventId Event ID to listen for. Derived Event classes should
-   * provide a static event id string that can be referenced.
+   * provide a static event id string that can be referenced. May be a
+   * wildcard pattern such as "Clock/#" to listen for every matching Event ID.
    * @param aEventCallback Callback to be run when an Event of the given ID is
-   * dispatched. Callers should dynamic_cast the Event to the expected derived
-   * Event class.
+   * dispatched. Prefer the typed Listen<TEvent> overload, which hands the
+   * Callback the derived Event class directly.
+   * @param aOptions Where the Callback runs
+   * @return ListenerId ID for Unlisten, or InvalidListenerId if the Event ID
+   * or executor strand could not be allocated
    */
-  void Listen(std::string aEventId,
-              std::function<void(Event &)> aEventCallback);
+  ListenerId Listen(const char *aEventId, EventCallback aEventCallback,
+                    const ListenerOptions &aOptions = ListenerOptions());
+
+  /**
+   * @brief Registers a listener for an already interned Event ID
+   *
+   * @param aEventId interned Event ID to listen for, see GetEventId
+   * @param aEventCallback Callback to be run when an Event of the given ID is
+   * dispatched.
+   * @param aOptions Where the Callback runs
+   * @return ListenerId ID for Unlisten, or InvalidListenerId if the Event ID
+   * or executor strand could not be allocated
+   */
+  ListenerId Listen(EventId aEventId, EventCallback aEventCallback,
+                    const ListenerOptions &aOptions = ListenerOptions());
+
+  /**
+   * @brief Registers a listener for a derived Event class
+   *
+   * The Event type is matched at compile time through its interned ID, so the
+   * Callback receives the derived Event without any dynamic_cast or copy.
+   *
+   * @tparam TEvent Derived Event class to listen for
+   * @param aEventCallback Callable taking a const TEvent&
+   * @param aOptions Where the Callback runs
+   * @return ListenerId ID for Unlisten, or InvalidListenerId if the Event ID
+   * or executor strand could not be allocated
+   */
+  template <typename TEvent, typename TCallback>
+  ListenerId Listen(TCallback &&aEventCallback,
+                    const ListenerOptions &aOptions = ListenerOptions()) {
+    return Listen(GetEventId<TEvent>(),
+                  [callback = std::forward<TCallback>(aEventCallback)](
+                      const Event &aEvent) {
+                    callback(static_cast<const TEvent &>(aEvent));
+                  },
+                  aOptions);
+  }
+
+  /**
+   * @brief Removes a listener
+   *
+   * Events already queued may still be delivered to the listener. Executor
+   * strands stay allocated until the executor is destroyed.
+   *
+   * @param aListenerId ID returned by Listen
+   * @return true the listener was removed
+   * @return false no listener with this ID is registered
+   */
+  bool Unlisten(ListenerId aListenerId);
+
+  /**
+   * @brief Records every Event passing through Dispatch and DispatchNow
+   *
+   * The recorder must outlive the dispatcher, or be detached first.
+   *
+   * @param aRecorder Recorder to attach, or nullptr to stop recording
+   */
+  void SetRecorder(EventRecorder *aRecorder);
 
  private:
-  std::unordered_map<std::string, std::vector<std::function<void(Event &)>>>
-      mCallbacks;
+  template <typename TEvent, typename... TArgs>
+  DispatchStatus DispatchTyped(bool aInline, TArgs &&...aArgs) {
+    auto event =
+        EventPool<TEvent>::Instance().Make(std::forward<TArgs>(aArgs)...);
+    DispatchOptions options;
+    options.mPriority = TEvent::Priority;
+    if constexpr (TEvent::DeadlineMs > 0) {
+      options.mDeadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(TEvent::DeadlineMs);
+    }
+    options.mOverflow = TEvent::Overflow;
+    options.mBlockTimeout = std::chrono::milliseconds(TEvent::BlockTimeoutMs);
+    uint16_t key = 0;
+    if constexpr (TEvent::Overflow == OverflowPolicy::Conflate) {
+      key = static_cast<const TEvent &>(*event).GetConflationKey();
+    }
+    return Route(std::move(event), aInline, key, options);
+  }
+
+  DispatchStatus Route(EventPtr aEvent, bool aInline, uint16_t aKey,
+                       const DispatchOptions &aOptions);
+  DispatchStatus Enqueue(EventPtr aEvent, ListenerSnapshot aListeners,
+                         uint16_t aKey, const DispatchOptions &aOptions);
+
+  struct PatternListener {
+    std::string mPattern;
+    Listener mListener;
+  };
+
+  bool MakeListener(EventCallback aEventCallback,
+                    const ListenerOptions &aOptions, Listener &aListener);
+  ListenerId ListenPattern(const char *aPattern, EventCallback aEventCallback,
+                           const ListenerOptions &aOptions);
+  void CompilePatterns();
+  void Resolve(EventId aEventId);
+  void ResolveAll();
+  void ResolveNewIds();
+
+  // Every listener of one Event ID, published as one snapshot so Route sees
+  // the inline and queued lists of the same registration
+  struct ListenerSet {
+    ListenerList mAll;
+    // mAll without the inline listeners, queued by DispatchNow. Left empty
+    // when mHasInline is false, mAll is queued instead.
+    ListenerList mQueued;
+    bool mHasInline = false;
+  };
+  typedef std::shared_ptr<const ListenerSet> ListenerSetSnapshot;
+
+  ListenerSetSnapshot GetListeners(EventId aEventId) const;
+  void Publish(EventId aEventId, ListenerList aListeners);
+
+  // Indexed by EventId. Snapshots are read with std::atomic_load so Dispatch
+  // never takes mMutex, which only serializes Listen and Unlisten.
+  std::array<ListenerSetSnapshot, MaxEventIds> mListeners;
+  // Registered listeners the snapshots are resolved from, guarded by mMutex
+  std::array<ListenerList, MaxEventIds> mExactListeners;
+  std::vector<PatternListener> mPatternListeners;
+  TopicTrie mPatterns;
+  std::vector<size_t> mMatches;
+  // Event IDs below this count include their pattern listeners
+  std::atomic<size_t> mResolvedIds{0};
+  std::atomic<EventRecorder *> mRecorder{nullptr};
   EventQueue &mEventQueue;
   std::mutex mMutex;
+  std::atomic<ListenerId> mNextListenerId{InvalidListenerId + 1};
 };
 }  // namespace Events
 
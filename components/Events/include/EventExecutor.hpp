@@ -0,0 +1,164 @@
+/**
+ * @file EventExecutor.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_EXECUTOR_H
+#define EVENT_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventListener.hpp"
+#include "EventPool.hpp"
+#include "MpscRingBuffer.hpp"
+#include "ScopedThreadConfig.hpp"
+
+namespace Events {
+/**
+ * @brief Serializes the Events of one listener on an EventExecutor
+ *
+ * A strand is scheduled on at most one worker at a time, so a listener sees
+ * its Events in dispatch order even when it may run on any worker.
+ */
+class EventStrand {
+ public:
+  EventStrand(EventExecutor &aExecutor, ListenerId aListenerId,
+              EventCallback aCallback, int aWorker, size_t aDepth);
+
+  EventStrand(const EventStrand &) = delete;
+  EventStrand &operator=(const EventStrand &) = delete;
+
+  /**
+   * @brief Queues an Event for the listener and schedules the strand
+   *
+   * Must only be called from the thread processing the Event Queue.
+   *
+   * @param aEvent Event to deliver
+   */
+  void Post(const EventRef &aEvent);
+
+  /**
+   * @brief Returns the number of Events dropped because the listener fell
+   * more than its queue depth behind
+   *
+   * @return uint32_t
+   */
+  uint32_t GetDropped() const;
+
+ private:
+  friend class EventExecutor;
+
+  static constexpr size_t RunBatch = 8;
+
+  void Run();
+
+  EventExecutor &mExecutor;
+  const ListenerId mListenerId;
+  EventCallback mCallback;
+  const int mWorker;
+  MpscRingBuffer<EventRef> mPending;
+  std::atomic<bool> mScheduled{false};
+  std::atomic<uint32_t> mDropped{0};
+};
+
+/**
+ * @brief Pool of worker threads that run listener Callbacks off the Event
+ * Queue thread
+ *
+ * Listeners are pinned to a worker or run on whichever worker is idle. A slow
+ * Callback then only delays the listeners sharing its worker instead of every
+ * listener in the system.
+ */
+class EventExecutor {
+ public:
+  static constexpr int NoCoreAffinity =
+      Common::ScopedThreadConfig::NoCoreAffinity;
+  static constexpr size_t DefaultMaxStrands = 16;
+  static constexpr size_t DefaultStrandDepth = 8;
+
+  /**
+   * @brief Construct a new Event Executor and start workers that may run on
+   * any core
+   *
+   * @param aWorkerCount Number of worker threads
+   * @param aMaxStrands Maximum number of listeners using the executor
+   */
+  explicit EventExecutor(size_t aWorkerCount,
+                         size_t aMaxStrands = DefaultMaxStrands);
+
+  /**
+   * @brief Creates an Event Executor with one worker per entry of aWorkerCores
+   *
+   * @param aWorkerCores The CPU core each worker is pinned to, or
+   * NoCoreAffinity. Core pinning only applies on ESP32 targets.
+   * @param aMaxStrands Maximum number of listeners using the executor
+   * @return EventExecutor
+   */
+  static EventExecutor WithCores(std::initializer_list<int> aWorkerCores,
+                                 size_t aMaxStrands = DefaultMaxStrands);
+  ~EventExecutor();
+
+  EventExecutor(const EventExecutor &) = delete;
+  EventExecutor &operator=(const EventExecutor &) = delete;
+
+  /**
+   * @brief Creates the strand a listener's Events are run through
+   *
+   * @param aListenerId ID of the listener
+   * @param aCallback Listener Callback
+   * @param aWorker Worker index, or ListenerOptions::AnyWorker
+   * @param aDepth Number of Events the listener may fall behind before Events
+   * are dropped
+   * @return EventStrand* strand owned by the executor, or nullptr if the
+   * executor has no strands left or aWorker is out of range
+   */
+  EventStrand *CreateStrand(ListenerId aListenerId, EventCallback aCallback,
+                            int aWorker, size_t aDepth = DefaultStrandDepth);
+
+  /**
+   * @brief Returns the number of worker threads
+   *
+   * @return size_t
+   */
+  size_t GetWorkerCount() const;
+
+ private:
+  friend class EventStrand;
+
+  // Fixed-capacity FIFO of ready strands. A strand is queued at most once, so
+  // mMaxStrands slots never overflow.
+  struct ReadyQueue {
+    std::unique_ptr<EventStrand *[]> mStrands;
+    size_t mHead = 0;
+    size_t mSize = 0;
+  };
+
+  EventExecutor(const int *aWorkerCores, size_t aWorkerCount,
+                size_t aMaxStrands);
+
+  void Schedule(EventStrand *aStrand);
+  void WorkerLoop(size_t aIndex);
+  void StartWorker(size_t aIndex, int aCore);
+  bool PopReady(ReadyQueue &aQueue, EventStrand *&aStrand);
+
+  const size_t mMaxStrands;
+  std::vector<std::unique_ptr<EventStrand>> mStrands;
+  // One queue per worker for pinned strands, plus a shared queue last
+  std::vector<ReadyQueue> mReady;
+  std::vector<std::thread> mWorkers;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mStopped = false;
+};
+}  // namespace Events
+
+#endif  // EVENT_EXECUTOR_H
@@ -0,0 +1,79 @@
+/**
+ * @file EventId.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_ID_H
+#define EVENT_ID_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Events {
+/**
+ * @brief Small integer identifying an Event type
+ *
+ * Event ID strings are interned into EventIds once so the Event Dispatcher can
+ * look up Callbacks with a single array index instead of hashing strings.
+ *
+ * Event ID strings may be hierarchical, with levels separated by '/', e.g.
+ * "Clock/Time", so listeners can subscribe to a whole subtree of Events.
+ * EventIds are assigned in interning order starting at zero.
+ */
+typedef uint8_t EventId;
+
+static constexpr size_t MaxEventIds = 32;
+static constexpr EventId InvalidEventId = 0xFF;
+// Longest Event ID string, excluding the terminator
+static constexpr size_t MaxEventNameLength = 31;
+
+/**
+ * @brief Interns an Event ID string
+ *
+ * This thread-safe function returns the same EventId for every call with an
+ * equal string.
+ *
+ * @param aName Event ID string, copied into the registry so it may be a
+ * temporary
+ * @return EventId interned ID, or InvalidEventId if MaxEventIds is exceeded
+ * or aName is longer than MaxEventNameLength
+ */
+EventId InternEventId(const char *aName);
+
+/**
+ * @brief Returns the Event ID string an EventId was interned from
+ *
+ * @param aId interned Event ID
+ * @return const char* Event ID string, valid for the rest of the program, or
+ * nullptr if aId is not interned
+ */
+const char *GetEventName(EventId aId);
+
+/**
+ * @brief Returns the number of interned Event IDs
+ *
+ * Every EventId below this count is interned.
+ *
+ * @return size_t
+ */
+size_t GetEventIdCount();
+
+/**
+ * @brief Returns the interned EventId of an Event class
+ *
+ * The Event ID string is interned on the first call only, later calls cost a
+ * single guard check.
+ *
+ * @tparam TEvent Event class providing a static Id string
+ * @return EventId
+ */
+template <typename TEvent>
+EventId GetEventId() {
+  static const EventId id = InternEventId(TEvent::Id);
+  return id;
+}
+}  // namespace Events
+
+#endif  // EVENT_ID_H
@@ -0,0 +1,90 @@
+/**
+ * @file EventListener.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_LISTENER_H
+#define EVENT_LISTENER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Event.hpp"
+#include "InplaceFunction.hpp"
+
+namespace Events {
+class EventExecutor;
+class EventStrand;
+
+/**
+ * @brief Bytes of captured state a listener or timer Callback may hold.
+ * Larger captures fail to compile, capture a pointer to the state instead.
+ */
+static constexpr size_t CallbackCapacity = 4 * sizeof(void *);
+
+typedef Common::InplaceFunction<void(const Event &), CallbackCapacity>
+    EventCallback;
+
+/**
+ * @brief Identifies a registered listener so it can be removed again. Zero is
+ * never a valid ListenerId.
+ */
+typedef uint32_t ListenerId;
+static constexpr ListenerId InvalidListenerId = 0;
+
+/**
+ * @brief Options controlling where a listener's Callback runs
+ *
+ */
+struct ListenerOptions {
+  static constexpr int AnyWorker = -1;
+
+  /**
+   * @brief Executor to run the Callback on. When null the Callback runs on the
+   * thread processing the Event Queue.
+   */
+  EventExecutor *mExecutor = nullptr;
+
+  /**
+   * @brief Index of the executor worker the Callback is pinned to, or
+   * AnyWorker to let any idle worker run it
+   */
+  int mWorker = AnyWorker;
+
+  /**
+   * @brief When true, EventDispatcher::DispatchNow runs the Callback directly
+   * on the dispatching thread instead of queueing the Event. Events sent with
+   * EventDispatcher::Dispatch still reach the Callback on the Event Queue
+   * thread. Ignored when mExecutor is set.
+   */
+  bool mInline = false;
+};
+
+/**
+ * @brief A registered Callback
+ *
+ * Listeners running on an EventExecutor own an EventStrand that holds the
+ * Callback and keeps their Events in order.
+ */
+struct Listener {
+  EventCallback mCallback;
+  EventStrand *mStrand = nullptr;
+  ListenerId mId = InvalidListenerId;
+  bool mInline = false;
+};
+
+/**
+ * @brief Immutable snapshot of the listeners of one Event ID
+ *
+ * Snapshots are replaced, never modified, when listeners are added or removed.
+ * A queued Event holds a reference to the snapshot taken at dispatch, which
+ * stays valid however the registry changes in the meantime.
+ */
+typedef std::vector<Listener> ListenerList;
+typedef std::shared_ptr<const ListenerList> ListenerSnapshot;
+}  // namespace Events
+
+#endif  // EVENT_LISTENER_H
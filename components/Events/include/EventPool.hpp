@@ -0,0 +1,242 @@
+/**
+ * @file EventPool.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Event.hpp"
+
+namespace Events {
+/**
+ * @brief Destroys an Event and returns its storage to the pool it came from
+ *
+ * A default constructed EventDeleter deletes heap allocated Events.
+ */
+struct EventDeleter {
+  void (*mRelease)(Event *) = nullptr;
+
+  void operator()(Event *aEvent) const {
+    if (mRelease) {
+      mRelease(aEvent);
+    } else {
+      delete aEvent;
+    }
+  }
+};
+
+typedef std::unique_ptr<Event, EventDeleter> EventPtr;
+
+/**
+ * @brief Shared, reference counted handle to a dispatched Event
+ *
+ * Used when one Event is delivered to listeners on several threads. The count
+ * lives inside the Event so sharing does not allocate, and the Event is
+ * released through its EventDeleter when the last EventRef goes away.
+ */
+class EventRef {
+ public:
+  EventRef() = default;
+  explicit EventRef(EventPtr aEvent)
+      : mEvent(aEvent.get()), mDeleter(aEvent.get_deleter()) {
+    aEvent.release();
+    if (mEvent) {
+      mEvent->mRefCount.store(1, std::memory_order_relaxed);
+    }
+  }
+  EventRef(const EventRef &aOther)
+      : mEvent(aOther.mEvent), mDeleter(aOther.mDeleter) {
+    if (mEvent) {
+      mEvent->mRefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  EventRef(EventRef &&aOther) noexcept
+      : mEvent(aOther.mEvent), mDeleter(aOther.mDeleter) {
+    aOther.mEvent = nullptr;
+  }
+  EventRef &operator=(EventRef aOther) noexcept {
+    std::swap(mEvent, aOther.mEvent);
+    std::swap(mDeleter, aOther.mDeleter);
+    return *this;
+  }
+  ~EventRef() {
+    if (mEvent &&
+        mEvent->mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      mDeleter(mEvent);
+    }
+  }
+
+  const Event &operator*() const { return *mEvent; }
+  const Event *operator->() const { return mEvent; }
+  explicit operator bool() const { return mEvent != nullptr; }
+
+ private:
+  Event *mEvent = nullptr;
+  EventDeleter mDeleter;
+};
+
+/**
+ * @brief Usage statistics of an Event Pool
+ *
+ */
+struct PoolStats {
+  size_t mCapacity;
+  size_t mInUse;
+  size_t mHighWater;
+  size_t mExhausted;
+};
+
+/**
+ * @brief Fixed-capacity object pool for one Event class
+ *
+ * Storage for TEvent::PoolSize Events is reserved statically and handed out
+ * through a lock-free free list, so dispatching Events does not touch the heap
+ * in steady state. When the pool is exhausted Events fall back to the heap and
+ * the miss is counted in PoolStats::mExhausted.
+ *
+ * @tparam TEvent Derived Event class stored in the pool
+ */
+template <typename TEvent>
+class EventPool {
+  static constexpr size_t Capacity = TEvent::PoolSize;
+  static constexpr uint16_t EndOfList = 0xFFFF;
+  static_assert(Capacity > 0 && Capacity < EndOfList,
+                "PoolSize must be between 1 and 65534");
+
+ public:
+  /**
+   * @brief Returns the pool shared by all Events of type TEvent
+   *
+   * @return EventPool&
+   */
+  static EventPool &Instance() {
+    static EventPool pool;
+    return pool;
+  }
+
+  EventPool(const EventPool &) = delete;
+  EventPool &operator=(const EventPool &) = delete;
+
+  /**
+   * @brief Constructs an Event in pool storage
+   *
+   * @param aArgs Arguments forwarded to the TEvent constructor
+   * @return EventPtr owning the new Event
+   */
+  template <typename... TArgs>
+  EventPtr Make(TArgs &&...aArgs) {
+    const auto index = Acquire();
+    if (index == EndOfList) {
+      mExhausted.fetch_add(1, std::memory_order_relaxed);
+      return EventPtr(new TEvent(std::forward<TArgs>(aArgs)...),
+                      GetDeleter());
+    }
+
+    const auto inUse = mInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto highWater = mHighWater.load(std::memory_order_relaxed);
+    while (inUse > highWater &&
+           !mHighWater.compare_exchange_weak(highWater, inUse,
+                                             std::memory_order_relaxed)) {
+    }
+
+    auto event = new (&mStorage[index]) TEvent(std::forward<TArgs>(aArgs)...);
+    return EventPtr(event, GetDeleter());
+  }
+
+  /**
+   * @brief Returns the deleter of every EventPtr made by this pool, whether the
+   * Event is stored in the pool or fell back to the heap
+   *
+   * @return EventDeleter
+   */
+  static EventDeleter GetDeleter() {
+    return EventDeleter{&EventPool::Release};
+  }
+
+  /**
+   * @brief Returns usage statistics of the pool
+   *
+   * @return PoolStats
+   */
+  PoolStats GetStats() const {
+    return PoolStats{Capacity, mInUse.load(std::memory_order_relaxed),
+                     mHighWater.load(std::memory_order_relaxed),
+                     mExhausted.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  struct alignas(TEvent) Storage {
+    uint8_t mBytes[sizeof(TEvent)];
+  };
+
+  EventPool() {
+    for (size_t i = 0; i < Capacity; ++i) {
+      mNext[i].store(i + 1 < Capacity ? i + 1 : EndOfList,
+                     std::memory_order_relaxed);
+    }
+    mFreeHead.store(0, std::memory_order_relaxed);
+  }
+
+  static void Release(Event *aEvent) {
+    auto &pool = Instance();
+    auto event = static_cast<TEvent *>(aEvent);
+    const auto storage = reinterpret_cast<Storage *>(event);
+    if (storage < pool.mStorage || storage >= pool.mStorage + Capacity) {
+      delete event;
+      return;
+    }
+    const auto index = static_cast<uint16_t>(storage - pool.mStorage);
+    event->~TEvent();
+    pool.mInUse.fetch_sub(1, std::memory_order_relaxed);
+    pool.Free(index);
+  }
+
+  // The free list head packs a 16-bit ABA tag above the 16-bit slot index
+  uint16_t Acquire() {
+    auto head = mFreeHead.load(std::memory_order_acquire);
+    for (;;) {
+      const auto index = static_cast<uint16_t>(head & 0xFFFF);
+      if (index == EndOfList) {
+        return EndOfList;
+      }
+      const uint32_t next = mNext[index].load(std::memory_order_relaxed);
+      const uint32_t newHead = (((head >> 16) + 1) << 16) | next;
+      if (mFreeHead.compare_exchange_weak(head, newHead,
+                                          std::memory_order_acq_rel)) {
+        return index;
+      }
+    }
+  }
+
+  void Free(uint16_t aIndex) {
+    auto head = mFreeHead.load(std::memory_order_relaxed);
+    for (;;) {
+      mNext[aIndex].store(head & 0xFFFF, std::memory_order_relaxed);
+      const uint32_t newHead = (((head >> 16) + 1) << 16) | aIndex;
+      if (mFreeHead.compare_exchange_weak(head, newHead,
+                                          std::memory_order_release)) {
+        return;
+      }
+    }
+  }
+
+  Storage mStorage[Capacity];
+  std::atomic<uint16_t> mNext[Capacity];
+  std::atomic<uint32_t> mFreeHead;
+  std::atomic<size_t> mInUse{0};
+  std::atomic<size_t> mHighWater{0};
+  std::atomic<size_t> mExhausted{0};
+};
+}  // namespace Events
+
+#endif  // EVENT_POOL_H
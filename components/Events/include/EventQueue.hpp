@@ -8,26 +8,133 @@
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
-#include <functional>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <utility>
+#include <vector>
 
 #include "Event.hpp"
+#include "EventListener.hpp"
+#include "EventPool.hpp"
+#include "MpscRingBuffer.hpp"
 
 namespace Events {
-typedef std::pair<std::unique_ptr<Event>,
-                  std::vector<std::function<void(Event &)>> &>
-    DispatchEvent;
+/**
+ * @brief Holds the single pending Event of a conflating Event class and key
+ *
+ */
+struct ConflationSlot {
+  std::atomic<uint32_t> mKey{0};
+  std::atomic<Event *> mPending{nullptr};
+  EventDeleter mDeleter;
+};
+
+/**
+ * @brief An Event and the listeners it should be delivered to
+ *
+ * Conflated Events are not stored in the entry itself, the entry refers to
+ * the ConflationSlot holding the latest pending Event instead.
+ */
+struct DispatchEvent {
+  EventPtr mEvent;
+  ListenerSnapshot mListeners;
+  std::chrono::steady_clock::time_point mDispatchTime;
+  ConflationSlot *mSlot = nullptr;
+  std::chrono::steady_clock::time_point mDeadline =
+      std::chrono::steady_clock::time_point::max();
+};
+
+/**
+ * @brief How an Event is ordered in the Event Queue
+ *
+ */
+struct DispatchOptions {
+  static constexpr auto NoDeadline =
+      std::chrono::steady_clock::time_point::max();
+
+  EventPriority mPriority = EventPriority::Normal;
+  std::chrono::steady_clock::time_point mDeadline = NoDeadline;
+  OverflowPolicy mOverflow = OverflowPolicy::DropNewest;
+  std::chrono::milliseconds mBlockTimeout{0};
+};
+
+/**
+ * @brief Outcome of dispatching an Event
+ *
+ */
+enum class DispatchStatus : uint8_t {
+  // Queued for its listeners
+  Queued,
+  // Replaced a pending Event of the same class and conflation key
+  Conflated,
+  // Every listener ran inline, nothing was queued
+  Delivered,
+  // Nothing listens for the Event
+  NoListeners,
+  // Queued after dropping the oldest pending Event of its lane
+  DroppedOldest,
+  // The lane was full and the Event was dropped
+  Dropped,
+  // The lane stayed full for the whole block timeout and the Event was
+  // dropped
+  TimedOut,
+};
+
+/**
+ * @brief Events lost or delayed because a lane was full
+ *
+ */
+struct OverflowStats {
+  uint32_t mDroppedNewest;
+  uint32_t mDroppedOldest;
+  uint32_t mTimedOut;
+  uint32_t mBlocked;
+  uint64_t mBlockedTotalUs;
+  uint32_t mBlockedMaxUs;
+};
+
+/**
+ * @brief Dispatch-to-callback latency measured by the Event Queue
+ *
+ */
+struct LatencyStats {
+  uint32_t mCount;
+  uint64_t mTotalUs;
+  uint32_t mMaxUs;
+};
 
 /**
  * @brief Thread-safe Event Queue for invoking Events
  *
+ * Backed by one bounded lock-free ring buffer per priority lane so that
+ * producers never wait on each other or on the consumer, and callbacks are
+ * invoked without holding any lock.
+ *
+ * Each lane holds a fixed number of Events, so memory stays bounded when the
+ * consumer stalls. What happens to Events dispatched into a full lane is
+ * chosen per Event by its OverflowPolicy.
+ *
+ * The consumer drains the highest priority lane first. An Event whose
+ * deadline is due within DeadlineSlack jumps ahead of higher lanes, and a
+ * lane passed over MaxSkips times in a row is served next so low priority
+ * Events are never starved.
  */
 class EventQueue {
  public:
-  EventQueue() = default;
+  static constexpr size_t DefaultCapacity = 32;
+  static constexpr auto DeadlineSlack = std::chrono::milliseconds(5);
+  static constexpr uint32_t MaxSkips = 8;
+
+  /**
+   * @brief Construct a new Event Queue
+   *
+   * @param aCapacity Maximum number of pending Events per priority lane,
+   * rounded up to the next power of two
+   */
+  explicit EventQueue(size_t aCapacity = DefaultCapacity);
   ~EventQueue() = default;
 
   EventQueue(const EventQueue &) = delete;
@@ -44,10 +151,41 @@ class EventQueue {
    * @brief Pops and invokes the next event from the Event Queue
    *
    * This function removes the next event from the Event Queue and invokes its
-   * callback function
+   * callback function. It must only be called from a single consumer thread.
    */
   void Pop();
 
+  /**
+   * @brief Waits for Events and invokes every pending Event
+   *
+   * Sleeps until a producer pushes an Event or the timeout expires, then
+   * drains the whole batch. Must only be called from a single consumer thread.
+   *
+   * @param aTimeout Maximum time to wait for the first Event
+   * @return size_t Number of Events invoked
+   */
+  size_t WaitAndDrain(std::chrono::milliseconds aTimeout);
+
+  /**
+   * @brief Processes Events on the calling thread until Stop is called
+   *
+   */
+  void RunLoop();
+
+  /**
+   * @brief Wakes the consumer and makes RunLoop return
+   *
+   */
+  void Stop();
+
+  /**
+   * @brief Returns the latency between an Event being pushed and its
+   * callbacks being invoked
+   *
+   * @return LatencyStats
+   */
+  LatencyStats GetLatencyStats() const;
+
   /**
    * @brief Adds an Event and Callback pair to the Event Queue
    *
@@ -55,15 +193,110 @@ class EventQueue {
    * the Event Queue.
    *
    * @param aEvent Event that was dispatched.
-   * @param aCallbacks List of callbacks associated with the Event.
+   * @param aListeners Snapshot of the listeners associated with the Event.
+   * @param aOptions Priority lane, deadline and overflow policy of the Event.
+   * OverflowPolicy::Conflate is treated as DropNewest, use PushLatest to
+   * conflate.
+   * @return DispatchStatus Queued, or how the overflow policy was applied
    */
-  void Push(std::unique_ptr<Event> aEvent,
-            std::vector<std::function<void(Event &)>> &aCallbacks);
+  DispatchStatus Push(EventPtr aEvent, ListenerSnapshot aListeners,
+                      const DispatchOptions &aOptions = DispatchOptions());
+
+  /**
+   * @brief Adds an Event to the Event Queue, replacing a pending Event with
+   * the same ID and key
+   *
+   * If an Event with the same ID and key has not been invoked yet it is
+   * released and aEvent takes its place in the queue without a new entry.
+   *
+   * @param aEvent Event that was dispatched. Its deleter must be the same for
+   * every Event with this ID, as it is for Events made by an EventPool.
+   * @param aListeners Snapshot of the listeners associated with the Event.
+   * @param aKey Conflation key, see Event::GetConflationKey
+   * @param aOptions Priority lane and deadline of the Event. A replaced Event
+   * keeps the lane of the Event it replaces.
+   * @return DispatchStatus Queued, Conflated, or Dropped if no Event was
+   * pending and the lane is full. Conflated is also returned when the lane was
+   * full but a newer Event replaced this one in the meantime and was queued.
+   */
+  DispatchStatus PushLatest(
+      EventPtr aEvent, ListenerSnapshot aListeners, uint16_t aKey,
+      const DispatchOptions &aOptions = DispatchOptions());
+
+  /**
+   * @brief Returns the number of pending Events replaced by newer ones
+   *
+   * @return uint32_t
+   */
+  uint32_t GetConflatedCount() const;
+
+  /**
+   * @brief Returns the number of Events invoked after their deadline
+   *
+   * @return uint32_t
+   */
+  uint32_t GetDeadlineMissCount() const;
+
+  /**
+   * @brief Returns the number of Events dropped or delayed by full lanes
+   *
+   * @return OverflowStats
+   */
+  OverflowStats GetOverflowStats() const;
 
  private:
-  std::queue<DispatchEvent> mQueue;
-  mutable std::mutex mMutex;
+  typedef MpscRingBuffer<DispatchEvent> Lane;
+
+  static constexpr size_t MaxConflationSlots = 16;
+  static constexpr uint32_t ClaimingSlot = 0xFFFFFFFF;
+  static constexpr size_t LaneCount =
+      static_cast<size_t>(EventPriority::Count);
+
+  // Lane heads popped by the consumer but not yet invoked, so lanes can be
+  // compared without peeking into slots producers are writing
+  struct StagedEvent {
+    DispatchEvent mEvent;
+    bool mValid = false;
+    uint32_t mSkips = 0;
+  };
+
+  ConflationSlot *FindSlot(EventId aId, uint16_t aKey, const EventPtr &aEvent);
+  DispatchStatus Enqueue(Lane &aLane, DispatchEvent &aEntry,
+                         const DispatchOptions &aOptions);
+  DispatchStatus EnqueueBlocking(Lane &aLane, DispatchEvent &aEntry,
+                                 std::chrono::milliseconds aTimeout);
+  DispatchStatus EnqueueEvicting(Lane &aLane, DispatchEvent &aEntry);
+  void Discard(DispatchEvent &aEntry);
+  void NotifySpace();
+  bool PopNext(DispatchEvent &aEvent);
+  size_t Drain();
+  void Invoke(DispatchEvent &aEvent);
+  void Notify();
+
+  std::unique_ptr<Lane> mLanes[LaneCount];
+  StagedEvent mStaged[LaneCount];
+  std::atomic<size_t> mStagedCount{0};
+  std::atomic<bool> mConsumerWaiting{false};
+  std::atomic<bool> mStopped{false};
+  std::mutex mWaitMutex;
+  std::condition_variable mWaitCondition;
+  std::atomic<uint32_t> mLatencyCount{0};
+  std::atomic<uint64_t> mLatencyTotalUs{0};
+  std::atomic<uint32_t> mLatencyMaxUs{0};
+  ConflationSlot mSlots[MaxConflationSlots];
+  std::atomic<uint32_t> mConflated{0};
+  std::atomic<uint32_t> mDeadlineMisses{0};
+  // Producers waiting for room with OverflowPolicy::Block
+  std::atomic<uint32_t> mBlockedProducers{0};
+  std::mutex mSpaceMutex;
+  std::condition_variable mSpaceCondition;
+  std::atomic<uint32_t> mDroppedNewest{0};
+  std::atomic<uint32_t> mDroppedOldest{0};
+  std::atomic<uint32_t> mTimedOut{0};
+  std::atomic<uint32_t> mBlocked{0};
+  std::atomic<uint64_t> mBlockedTotalUs{0};
+  std::atomic<uint32_t> mBlockedMaxUs{0};
 };
 }  // namespace Events
 
-#endif  // EVENT_QUEUE_H
\ No newline at end of file
+#endif  // EVENT_QUEUE_H
@@ -0,0 +1,140 @@
+/**
+ * @file EventRecorder.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "Event.hpp"
+#include "EventListener.hpp"
+#include "InplaceFunction.hpp"
+
+namespace Events {
+/**
+ * @brief Receives a recording stream in chunks, returns false to abort
+ *
+ */
+typedef Common::InplaceFunction<bool(const uint8_t *, size_t),
+                                CallbackCapacity>
+    RecordSink;
+
+/**
+ * @brief Recorder activity counters
+ *
+ */
+struct RecorderStats {
+  uint32_t mRecorded;
+  uint32_t mOverwritten;
+  size_t mBytes;
+};
+
+/**
+ * @brief Records dispatched Events into a fixed-size in-memory ring
+ *
+ * Each record holds a microsecond timestamp, the EventId and the payload
+ * written by Event::Serialize. When the ring is full the oldest records are
+ * overwritten, so the recorder always holds the most recent history.
+ *
+ * Flush writes the ring as a self-contained stream that EventReplayer can
+ * feed back through an EventDispatcher:
+ *
+ *   "EVR2", uint32 record bytes, uint8 name count,
+ *   per name: uint8 length, name bytes
+ *   per record: uint32 time us, uint8 EventId, uint8 payload size, payload
+ *
+ * Integers are little-endian. The record byte count marks the end of the
+ * stream, so it can be read back from a larger buffer such as a flash
+ * partition padded with erased 0xFF bytes. Timestamps wrap after about 71
+ * minutes and are unwrapped by the replayer.
+ */
+class EventRecorder {
+ public:
+  static constexpr size_t DefaultCapacity = 4096;
+  static constexpr size_t RecordHeaderSize = 6;
+  static constexpr size_t MaxPayloadSize = 255;
+  static constexpr uint8_t StreamMagic[4] = {'E', 'V', 'R', '2'};
+  static constexpr size_t StreamSizeBytes = 4;
+
+  /**
+   * @brief Construct a new Event Recorder
+   *
+   * @param aCapacity Size of the record ring in bytes
+   */
+  explicit EventRecorder(size_t aCapacity = DefaultCapacity);
+  ~EventRecorder() = default;
+
+  EventRecorder(const EventRecorder &) = delete;
+  EventRecorder &operator=(const EventRecorder &) = delete;
+
+  /**
+   * @brief Appends an Event to the ring. Safe to call from any thread.
+   *
+   * @param aEvent Event being dispatched
+   */
+  void Record(const Event &aEvent);
+
+  /**
+   * @brief Writes the recorded Events as a replayable stream, oldest first
+   *
+   * The ring is left untouched, call Clear to start a new recording.
+   *
+   * @param aSink Receives the stream in chunks
+   * @return true the whole stream was written
+   * @return false aSink aborted
+   */
+  bool Flush(const RecordSink &aSink);
+
+#ifdef ESP_PLATFORM
+  /**
+   * @brief Erases a data partition and writes the stream to it
+   *
+   * The records are copied to a temporary heap buffer first, so Record only
+   * waits for the copy, not for the flash operations.
+   *
+   * @param aLabel Label of the partition in the partition table
+   * @return true the stream was written
+   * @return false the partition was not found, is too small, or a flash
+   * operation failed
+   */
+  bool FlushToPartition(const char *aLabel);
+#endif
+
+  /**
+   * @brief Discards every record
+   *
+   */
+  void Clear();
+
+  /**
+   * @brief Returns the recorder activity counters
+   *
+   * @return RecorderStats
+   */
+  RecorderStats GetStats();
+
+ private:
+  static bool WriteHeader(const RecordSink &aSink, size_t aRecordsSize);
+  bool FlushLocked(const RecordSink &aSink);
+  void Append(const uint8_t *aData, size_t aSize);
+  uint8_t ByteAt(size_t aPosition) const;
+
+  const size_t mCapacity;
+  std::unique_ptr<uint8_t[]> mBuffer;
+  // Monotonic byte positions, taken modulo mCapacity to index mBuffer
+  size_t mHead = 0;
+  size_t mTail = 0;
+  uint32_t mRecorded = 0;
+  uint32_t mOverwritten = 0;
+  std::mutex mMutex;
+};
+}  // namespace Events
+
+#endif  // EVENT_RECORDER_H
@@ -0,0 +1,119 @@
+/**
+ * @file EventReplayer.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_REPLAYER_H
+#define EVENT_REPLAYER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EventDispatcher.hpp"
+#include "EventPool.hpp"
+
+namespace Events {
+/**
+ * @brief Rebuilds an Event from a recorded payload
+ *
+ * @return EventPtr the Event, or null if the payload is malformed
+ */
+typedef EventPtr (*EventDecoder)(const uint8_t *aPayload, size_t aSize);
+
+/**
+ * @brief Pace of a replay
+ *
+ */
+enum class ReplaySpeed : uint8_t {
+  // Keep the recorded gaps between Events
+  Recorded,
+  // Dispatch every Event back to back
+  AsFastAsPossible,
+};
+
+/**
+ * @brief Outcome of a replay
+ *
+ */
+struct ReplayStats {
+  uint32_t mRecords;
+  uint32_t mDispatched;
+  // Records of Event IDs without a decoder, or with malformed payloads
+  uint32_t mUndecoded;
+  // Events the Event Queue did not accept
+  uint32_t mDropped;
+  uint64_t mRecordedUs;
+  uint64_t mReplayUs;
+};
+
+/**
+ * @brief Feeds a stream written by EventRecorder::Flush back through an
+ * EventDispatcher
+ *
+ * Records are matched to decoders by Event ID string, so a stream recorded on
+ * the device replays on a host build where EventIds may be interned in a
+ * different order.
+ */
+class EventReplayer {
+ public:
+  // How long a fast replay waits for the consumer before dropping an Event
+  static constexpr auto FastReplayBlockTimeout = std::chrono::milliseconds(100);
+
+  explicit EventReplayer(EventDispatcher &aDispatcher);
+  ~EventReplayer() = default;
+
+  /**
+   * @brief Registers the decoder of an Event ID
+   *
+   * @param aEventId Event ID string, as recorded
+   * @param aDecoder Decoder building Events of this ID
+   */
+  void AddDecoder(const char *aEventId, EventDecoder aDecoder);
+
+  /**
+   * @brief Registers TEvent::Deserialize as the decoder of TEvent::Id
+   *
+   * @tparam TEvent Event class providing a static Deserialize
+   */
+  template <typename TEvent>
+  void AddDecoder() {
+    AddDecoder(TEvent::Id, &TEvent::Deserialize);
+  }
+
+  /**
+   * @brief Dispatches every decodable record of a stream on the calling
+   * thread
+   *
+   * Replaying as fast as possible blocks on a full Event Queue instead of
+   * dropping Events, so the consumer must run on another thread.
+   *
+   * @param aStream Stream written by EventRecorder::Flush
+   * @param aSize Size of aStream in bytes, bytes after the end of the stream
+   * are ignored
+   * @param aSpeed Pace of the replay
+   * @param aStats Receives the outcome of the replay
+   * @return true the whole stream was replayed
+   * @return false the stream is malformed, records before the error were
+   * replayed
+   */
+  bool Replay(const uint8_t *aStream, size_t aSize, ReplaySpeed aSpeed,
+              ReplayStats &aStats);
+
+ private:
+  struct Decoder {
+    const char *mEventId;
+    EventDecoder mDecode;
+  };
+
+  EventDecoder FindDecoder(const uint8_t *aName, size_t aLength) const;
+
+  EventDispatcher &mDispatcher;
+  std::vector<Decoder> mDecoders;
+};
+}  // namespace Events
+
+#endif  // EVENT_REPLAYER_H
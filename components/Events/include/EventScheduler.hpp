@@ -0,0 +1,206 @@
+/**
+ * @file EventScheduler.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EventListener.hpp"
+#include "InplaceFunction.hpp"
+
+namespace Events {
+/**
+ * @brief Callback run when a timer expires. Usually dispatches an Event.
+ *
+ */
+typedef Common::InplaceFunction<void(), CallbackCapacity> TimerCallback;
+
+/**
+ * @brief Identifies a scheduled timer so it can be cancelled. Zero is never a
+ * valid TimerHandle.
+ */
+typedef uint32_t TimerHandle;
+static constexpr TimerHandle InvalidTimerHandle = 0;
+
+/**
+ * @brief Scheduler activity counters
+ *
+ */
+struct SchedulerStats {
+  uint32_t mWakeups;
+  uint32_t mFired;
+  uint32_t mArmed;
+  float mWakeupsPerSecond;
+};
+
+/**
+ * @brief Runs one-shot and periodic timers from a single sleeping thread
+ *
+ * Timers are kept in a three level hierarchical timer wheel with a 10 ms
+ * tick, covering about 2.9 hours before timers are re-cascaded. Timer nodes
+ * come from a fixed pool sized at construction, so scheduling never
+ * allocates. The scheduler thread sleeps until the earliest timer is due, so
+ * an idle system costs no wakeups.
+ *
+ * Callbacks run on the scheduler thread one at a time and may schedule or
+ * cancel timers, including their own.
+ */
+class EventScheduler {
+ public:
+  static constexpr std::chrono::milliseconds TickPeriod{10};
+  static constexpr size_t DefaultMaxTimers = 16;
+
+  /**
+   * @brief Construct a new Event Scheduler and start its thread
+   *
+   * @param aMaxTimers Maximum number of timers scheduled at once
+   */
+  explicit EventScheduler(size_t aMaxTimers = DefaultMaxTimers);
+  ~EventScheduler();
+
+  EventScheduler(const EventScheduler &) = delete;
+  EventScheduler &operator=(const EventScheduler &) = delete;
+
+  /**
+   * @brief Runs a Callback once after a delay
+   *
+   * @param aDelay Time until the Callback runs, rounded up to whole ticks
+   * @param aCallback Callback to run
+   * @return TimerHandle handle for Cancel, or InvalidTimerHandle if every
+   * timer is in use
+   */
+  TimerHandle ScheduleOnce(std::chrono::milliseconds aDelay,
+                           TimerCallback aCallback);
+
+  /**
+   * @brief Runs a Callback every period, starting one period from now
+   *
+   * Periods missed while a Callback ran late are skipped rather than run back
+   * to back, so the timer keeps its phase.
+   *
+   * @param aPeriod Time between runs, rounded up to whole ticks
+   * @param aCallback Callback to run
+   * @return TimerHandle handle for Cancel, or InvalidTimerHandle if every
+   * timer is in use
+   */
+  TimerHandle SchedulePeriodic(std::chrono::milliseconds aPeriod,
+                               TimerCallback aCallback);
+
+  /**
+   * @brief Runs a Callback at the next wall-clock minute boundary
+   *
+   * The boundary is taken from the system clock each time the timer is
+   * armed, so repeating timers follow SNTP corrections instead of drifting.
+   * The timer itself runs on the steady clock, so a correction between arming
+   * and expiry can run the Callback slightly before the boundary. Callbacks
+   * reading the system clock should round to the nearest minute.
+   *
+   * @param aCallback Callback to run
+   * @param aRepeat Run again at every following minute boundary
+   * @return TimerHandle handle for Cancel, or InvalidTimerHandle if every
+   * timer is in use
+   */
+  TimerHandle ScheduleAtNextMinute(TimerCallback aCallback,
+                                   bool aRepeat = false);
+
+  /**
+   * @brief Cancels a timer
+   *
+   * A Callback that is already running finishes, but is not run again.
+   *
+   * @param aHandle Handle returned when the timer was scheduled
+   * @return true the timer was cancelled
+   * @return false the timer already expired or was cancelled
+   */
+  bool Cancel(TimerHandle aHandle);
+
+  /**
+   * @brief Returns the scheduler activity counters
+   *
+   * mWakeupsPerSecond is averaged over the last window of at least one second
+   * that ended with a wakeup.
+   *
+   * @return SchedulerStats
+   */
+  SchedulerStats GetStats();
+
+ private:
+  static constexpr uint16_t NoTimer = 0xFFFF;
+  static constexpr size_t Level0Bits = 8;
+  static constexpr size_t LevelBits = 6;
+  static constexpr uint64_t Level0Size = 1u << Level0Bits;
+  static constexpr uint64_t LevelSize = 1u << LevelBits;
+  static constexpr uint64_t WheelSpan = Level0Size * LevelSize * LevelSize;
+
+  enum class TimerState : uint8_t {
+    Free,
+    Armed,
+    Firing,
+    Cancelled,
+  };
+
+  struct Timer {
+    TimerCallback mCallback;
+    uint64_t mExpiry = 0;
+    uint64_t mPeriod = 0;
+    uint16_t *mSlot = nullptr;
+    uint16_t mNext = NoTimer;
+    uint16_t mPrev = NoTimer;
+    uint16_t mGeneration = 0;
+    TimerState mState = TimerState::Free;
+    bool mMinuteAligned = false;
+  };
+
+  TimerHandle Arm(uint64_t aDelay, uint64_t aPeriod, bool aMinuteAligned,
+                  TimerCallback aCallback);
+  void Insert(uint16_t aIndex);
+  void Link(uint16_t aIndex, uint16_t *aSlot);
+  void Unlink(uint16_t aIndex);
+  void Release(uint16_t aIndex);
+  void Cascade(uint16_t *aSlot);
+  void Advance(uint64_t aTick);
+  void RunExpired(std::unique_lock<std::mutex> &aLock);
+  void Rearm(uint16_t aIndex);
+  void UpdateNextExpiry();
+  void CountWakeup();
+  void ThreadLoop();
+  uint64_t NowTick() const;
+  uint64_t TickAfter(uint64_t aDelay) const;
+  static uint64_t ToTicks(std::chrono::milliseconds aDuration);
+  static uint64_t TicksToNextMinute();
+
+  std::vector<Timer> mTimers;
+  uint16_t mFree = NoTimer;
+  uint16_t mExpired = NoTimer;
+  uint16_t mLevel0[Level0Size];
+  uint16_t mLevel1[LevelSize];
+  uint16_t mLevel2[LevelSize];
+  const std::chrono::steady_clock::time_point mStart;
+  // Last tick the wheel was advanced to
+  uint64_t mCurrentTick = 0;
+  uint64_t mNextExpiry = UINT64_MAX;
+  uint32_t mArmed = 0;
+  uint32_t mWakeups = 0;
+  uint32_t mFired = 0;
+  uint32_t mWindowWakeups = 0;
+  std::chrono::steady_clock::time_point mWindowStart;
+  float mWakeupsPerSecond = 0;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mChanged = false;
+  bool mStopped = false;
+  std::thread mThread;
+};
+}  // namespace Events
+
+#endif  // EVENT_SCHEDULER_H
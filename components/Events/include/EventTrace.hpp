@@ -0,0 +1,223 @@
+/**
+ * @file EventTrace.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "EventId.hpp"
+#include "EventListener.hpp"
+
+/**
+ * Tracepoints compile to nothing unless EVENTS_TRACING is defined, which the
+ * component build does when CONFIG_EVENTS_TRACING is enabled in menuconfig.
+ */
+#ifdef EVENTS_TRACING
+#define EVENTS_TRACE(aStage, aEventId, aListenerId) \
+  ::Events::Trace::Record(aStage, aEventId, aListenerId)
+#define EVENTS_TRACE_QUEUE_LATENCY(aEventId, aLatencyUs) \
+  ::Events::Trace::RecordQueueLatency(aEventId, aLatencyUs)
+#define EVENTS_TRACE_LISTENER_LATENCY(aListenerId, aLatencyUs) \
+  ::Events::Trace::RecordListenerLatency(aListenerId, aLatencyUs)
+#define EVENTS_TRACE_QUEUE_DEPTH(aDepth) \
+  ::Events::Trace::RecordQueueDepth(aDepth)
+#else
+#define EVENTS_TRACE(aStage, aEventId, aListenerId) \
+  do {                                              \
+  } while (0)
+#define EVENTS_TRACE_QUEUE_LATENCY(aEventId, aLatencyUs) \
+  do {                                                   \
+  } while (0)
+#define EVENTS_TRACE_LISTENER_LATENCY(aListenerId, aLatencyUs) \
+  do {                                                         \
+  } while (0)
+#define EVENTS_TRACE_QUEUE_DEPTH(aDepth) \
+  do {                                   \
+  } while (0)
+#endif
+
+namespace Events {
+namespace Trace {
+// Number of threads whose trace rings are kept at the same time
+static constexpr size_t MaxTracedThreads = 16;
+
+/**
+ * @brief Point in the Event pipeline a trace record was taken at
+ *
+ */
+enum class Stage : uint8_t {
+  Dispatch,
+  Push,
+  Pop,
+  CallbackStart,
+  CallbackEnd,
+};
+
+/**
+ * @brief A single tracepoint hit
+ *
+ */
+struct TraceRecord {
+  uint32_t mTimeUs;
+  Stage mStage;
+  EventId mEventId;
+  ListenerId mListenerId;
+};
+
+/**
+ * @brief Summary of a latency histogram. Percentiles are reported as the
+ * upper bound of the power-of-two bucket they fall in.
+ */
+struct LatencySummary {
+  uint32_t mCount;
+  uint32_t mP50Us;
+  uint32_t mP99Us;
+  uint32_t mMaxUs;
+};
+
+/**
+ * @brief Records a tracepoint hit in the calling thread's trace ring
+ *
+ * @param aStage Pipeline stage
+ * @param aEventId Event being traced
+ * @param aListenerId Listener being invoked, or InvalidListenerId
+ */
+void Record(Stage aStage, EventId aEventId, ListenerId aListenerId);
+
+/**
+ * @brief Adds a dispatch-to-pop latency sample for an Event ID
+ *
+ * @param aEventId Event ID
+ * @param aLatencyUs Time the Event spent queued
+ */
+void RecordQueueLatency(EventId aEventId, uint32_t aLatencyUs);
+
+/**
+ * @brief Adds a callback duration sample for a listener
+ *
+ * @param aListenerId Listener ID
+ * @param aLatencyUs Time spent in the listener's Callback
+ */
+void RecordListenerLatency(ListenerId aListenerId, uint32_t aLatencyUs);
+
+/**
+ * @brief Updates the Event Queue depth high-water mark
+ *
+ * @param aDepth Current number of queued Events
+ */
+void RecordQueueDepth(size_t aDepth);
+
+/**
+ * @brief Returns the time-in-queue histogram summary of an Event ID
+ *
+ * @param aEventId Event ID
+ * @return LatencySummary all zero when tracing is disabled
+ */
+LatencySummary GetQueueLatency(EventId aEventId);
+
+/**
+ * @brief Returns the callback duration histogram summary of a listener
+ *
+ * @param aListenerId Listener ID
+ * @return LatencySummary all zero when tracing is disabled or the listener
+ * was never traced
+ */
+LatencySummary GetListenerLatency(ListenerId aListenerId);
+
+/**
+ * @brief Returns the highest Event Queue depth seen
+ *
+ * @return size_t
+ */
+size_t GetQueueHighWater();
+
+/**
+ * @brief Copies the most recent records of the calling thread's trace ring
+ *
+ * @param aRecords Destination buffer
+ * @param aMaxRecords Capacity of aRecords
+ * @return size_t Number of records copied, oldest first
+ */
+size_t GetThreadRecords(TraceRecord *aRecords, size_t aMaxRecords);
+
+/**
+ * @brief Copies the most recent records of any thread's trace ring
+ *
+ * Rings are claimed by threads on their first record and released when the
+ * thread exits. A released ring keeps its records until another thread
+ * claims it. Reading never blocks the thread writing the ring, records it
+ * overwrites during the copy are left out.
+ *
+ * @param aThreadIndex Ring index, below MaxTracedThreads
+ * @param aRecords Destination buffer
+ * @param aMaxRecords Capacity of aRecords
+ * @return size_t Number of records copied, oldest first
+ */
+size_t GetThreadRecords(size_t aThreadIndex, TraceRecord *aRecords,
+                        size_t aMaxRecords);
+
+/**
+ * @brief Returns the index of the calling thread's trace ring
+ *
+ * @return size_t index for GetThreadRecords, or MaxTracedThreads if tracing
+ * is disabled or every ring is taken
+ */
+size_t GetThreadIndex();
+
+/**
+ * @brief Writes every non-empty histogram and the queue high-water mark as a
+ * single line JSON object
+ *
+ * The output is stable in field order so results from two builds can be
+ * diffed directly.
+ *
+ * @param aOut Stream to write to, e.g. stdout or a results file
+ */
+void WriteJson(std::FILE *aOut);
+
+/**
+ * @brief Clears all histograms and the queue high-water mark
+ *
+ */
+void Reset();
+
+/**
+ * @brief Returns a monotonic timestamp for tracing
+ *
+ * @return uint32_t microseconds, wrapping after about 71 minutes
+ */
+uint32_t NowUs();
+
+/**
+ * @brief Calls a listener Callback between the CallbackStart and CallbackEnd
+ * tracepoints and records its duration
+ *
+ * @param aCallback Listener Callback
+ * @param aEvent Event to pass to the Callback
+ * @param aListenerId ID of the listener
+ */
+inline void Invoke(const EventCallback &aCallback, const Event &aEvent,
+                   ListenerId aListenerId) {
+#ifdef EVENTS_TRACING
+  const auto eventId = aEvent.GetId();
+  Record(Stage::CallbackStart, eventId, aListenerId);
+  const auto start = NowUs();
+  aCallback(aEvent);
+  Record(Stage::CallbackEnd, eventId, aListenerId);
+  RecordListenerLatency(aListenerId, NowUs() - start);
+#else
+  (void)aListenerId;
+  aCallback(aEvent);
+#endif
+}
+}  // namespace Trace
+}  // namespace Events
+
+#endif  // EVENT_TRACE_H
@@ -0,0 +1,157 @@
+/**
+ * @file MpscRingBuffer.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef MPSC_RING_BUFFER_H
+#define MPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Events {
+/**
+ * @brief Size used to pad shared indices and slots so producers and the
+ * consumer do not false-share
+ */
+static constexpr size_t CacheLineSize = 64;
+
+/**
+ * @brief Bounded lock-free multi-producer/single-consumer ring buffer
+ *
+ * Each slot carries a sequence number that tells producers and the consumer
+ * whether the slot is free or holds a value for the current lap of the ring.
+ * Producers claim a position with a CAS on the head index and values are
+ * removed with a CAS on the tail index. Values are normally removed by a
+ * single consumer, the tail CAS additionally lets a producer evict the oldest
+ * value of a full ring. No locks are taken and no memory is allocated after
+ * construction.
+ *
+ * @tparam T Element type. Must be default constructible and move assignable.
+ */
+template <typename T>
+class MpscRingBuffer {
+  struct alignas(CacheLineSize) Slot {
+    std::atomic<size_t> mSequence;
+    T mValue;
+  };
+
+ public:
+  /**
+   * @brief Construct a new ring buffer
+   *
+   * @param aCapacity Number of slots, rounded up to the next power of two
+   */
+  explicit MpscRingBuffer(size_t aCapacity)
+      : mCapacity(RoundUpPowerOfTwo(aCapacity)),
+        mMask(mCapacity - 1),
+        mSlots(new Slot[mCapacity]) {
+    for (size_t i = 0; i < mCapacity; ++i) {
+      mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~MpscRingBuffer() = default;
+
+  MpscRingBuffer(const MpscRingBuffer &) = delete;
+  MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+  /**
+   * @brief Adds a value to the ring buffer. Safe to call from any thread.
+   *
+   * @param aValue Value to move into the ring buffer
+   * @return true the value was added
+   * @return false the ring buffer is full, aValue is left untouched
+   */
+  bool TryPush(T &&aValue) {
+    auto pos = mHead.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &slot = mSlots[pos & mMask];
+      const auto seq = slot.mSequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (mHead.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          slot.mValue = std::move(aValue);
+          slot.mSequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mHead.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Removes the oldest value from the ring buffer. Safe to call from
+   * any thread.
+   *
+   * @param aValue Destination for the removed value
+   * @return true a value was removed
+   * @return false the ring buffer is empty
+   */
+  bool TryPop(T &aValue) {
+    auto pos = mTail.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &slot = mSlots[pos & mMask];
+      const auto seq = slot.mSequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                        static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (mTail.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          aValue = std::move(slot.mValue);
+          slot.mValue = T();
+          slot.mSequence.store(pos + mCapacity, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mTail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Returns an approximate number of values in the ring buffer
+   *
+   * @return size_t
+   */
+  size_t Size() const {
+    const auto tail = mTail.load(std::memory_order_relaxed);
+    const auto head = mHead.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+  }
+
+  /**
+   * @brief Returns the number of slots in the ring buffer
+   *
+   * @return size_t
+   */
+  size_t Capacity() const { return mCapacity; }
+
+ private:
+  static size_t RoundUpPowerOfTwo(size_t aValue) {
+    size_t result = 1;
+    while (result < aValue) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  const size_t mCapacity;
+  const size_t mMask;
+  std::unique_ptr<Slot[]> mSlots;
+  alignas(CacheLineSize) std::atomic<size_t> mHead{0};
+  alignas(CacheLineSize) std::atomic<size_t> mTail{0};
+};
+}  // namespace Events
+
+#endif  // MPSC_RING_BUFFER_H
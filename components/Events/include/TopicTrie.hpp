@@ -0,0 +1,90 @@
+/**
+ * @file TopicTrie.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Events {
+/**
+ * @brief Matches hierarchical Event ID strings against subscription patterns
+ *
+ * Levels of a topic are separated by '/'. In a pattern a '*' level matches
+ * exactly one level and a trailing '#' level matches any number of remaining
+ * levels, including none: "Clock/#" matches "Clock", "Clock/Time" and
+ * "Clock/Alarm/Set".
+ *
+ * Patterns are compiled into a trie with one node per distinct pattern
+ * prefix, so matching walks each topic level once per live branch instead of
+ * comparing the topic against every pattern.
+ */
+class TopicTrie {
+ public:
+  static constexpr char Separator = '/';
+  static constexpr char AnyLevel = '*';
+  static constexpr char AnyLevels = '#';
+
+  TopicTrie();
+
+  /**
+   * @brief Returns whether a string contains wildcard levels
+   *
+   * @param aTopic Topic or pattern
+   * @return true aTopic is a pattern
+   * @return false aTopic is a plain topic
+   */
+  static bool IsPattern(const char *aTopic);
+
+  /**
+   * @brief Removes every pattern
+   *
+   */
+  void Clear();
+
+  /**
+   * @brief Adds a pattern
+   *
+   * @param aPattern Pattern to match topics against
+   * @param aValue Value reported by Match for topics matching aPattern
+   */
+  void Insert(const char *aPattern, size_t aValue);
+
+  /**
+   * @brief Finds every pattern matching a topic
+   *
+   * @param aTopic Topic to match
+   * @param aValues Receives the values of the matching patterns in ascending
+   * order
+   */
+  void Match(const char *aTopic, std::vector<size_t> &aValues) const;
+
+ private:
+  static constexpr uint16_t NoNode = 0xFFFF;
+
+  struct Node {
+    std::string mLevel;
+    std::vector<uint16_t> mChildren;
+    uint16_t mAnyLevel = NoNode;
+    // Values of patterns ending at this node, and of patterns ending with
+    // '#' right after it
+    std::vector<size_t> mValues;
+    std::vector<size_t> mAnyLevelsValues;
+  };
+
+  uint16_t Child(uint16_t aNode, const char *aLevel, size_t aLength);
+  void MatchFrom(uint16_t aNode, const char *aTopic,
+                 std::vector<size_t> &aValues) const;
+
+  std::vector<Node> mNodes;
+};
+}  // namespace Events
+
+#endif  // TOPIC_TRIE_H
@@ -7,21 +7,245 @@
  */
 #include "EventDispatcher.hpp"
 
+#include "EventTrace.hpp"
+
 namespace Events {
+namespace {
+// Set while inline Callbacks run on this thread. A DispatchNow from inside one
+// of them is queued, so inline Callbacks cannot recurse into each other.
+thread_local bool tInlineDispatch = false;
+
+struct InlineGuard {
+  InlineGuard() { tInlineDispatch = true; }
+  ~InlineGuard() { tInlineDispatch = false; }
+};
+}  // namespace
+
 EventDispatcher::EventDispatcher(EventQueue &aEventQueue)
     : mEventQueue(aEventQueue) {}
 
-void EventDispatcher::Dispatch(std::unique_ptr<Event> aEvent) {
+DispatchStatus EventDispatcher::Dispatch(std::unique_ptr<Event> aEvent) {
+  return Dispatch(EventPtr(aEvent.release()));
+}
+
+DispatchStatus EventDispatcher::Dispatch(EventPtr aEvent,
+                                         const DispatchOptions &aOptions) {
+  return Route(std::move(aEvent), false, 0, aOptions);
+}
+
+DispatchStatus EventDispatcher::DispatchNow(EventPtr aEvent,
+                                            const DispatchOptions &aOptions) {
+  return Route(std::move(aEvent), true, 0, aOptions);
+}
+
+DispatchStatus EventDispatcher::Route(EventPtr aEvent, bool aInline,
+                                      uint16_t aKey,
+                                      const DispatchOptions &aOptions) {
+  const auto eventId = aEvent->GetId();
+  EVENTS_TRACE(Trace::Stage::Dispatch, eventId, InvalidListenerId);
+  if (const auto recorder = mRecorder.load(std::memory_order_acquire)) {
+    recorder->Record(*aEvent);
+  }
+  if (eventId >= mResolvedIds.load(std::memory_order_acquire) &&
+      eventId < MaxEventIds) {
+    // First dispatch of an Event ID interned after the patterns were last
+    // resolved
+    ResolveNewIds();
+  }
+  // One snapshot for both paths, so a concurrent Listen or Unlisten cannot
+  // make the inline and queued lists disagree
+  auto listeners = GetListeners(eventId);
+  if (!listeners || listeners->mAll.empty()) {
+    return DispatchStatus::NoListeners;
+  }
+  const auto set = listeners.get();
+  if (!aInline || tInlineDispatch || !set->mHasInline) {
+    // Inline listeners are queued with the rest and run on the Event Queue
+    // thread
+    return Enqueue(std::move(aEvent),
+                   ListenerSnapshot(std::move(listeners), &set->mAll), aKey,
+                   aOptions);
+  }
+
+  {
+    InlineGuard guard;
+    for (const auto &listener : set->mAll) {
+      if (!listener.mInline) {
+        continue;
+      }
+      Trace::Invoke(listener.mCallback, *aEvent, listener.mId);
+    }
+  }
+  if (set->mQueued.empty()) {
+    return DispatchStatus::Delivered;
+  }
+  return Enqueue(std::move(aEvent),
+                 ListenerSnapshot(std::move(listeners), &set->mQueued), aKey,
+                 aOptions);
+}
+
+DispatchStatus EventDispatcher::Enqueue(EventPtr aEvent,
+                                        ListenerSnapshot aListeners,
+                                        uint16_t aKey,
+                                        const DispatchOptions &aOptions) {
+  if (!aListeners || aListeners->empty()) {
+    return DispatchStatus::NoListeners;
+  }
+  if (aOptions.mOverflow == OverflowPolicy::Conflate) {
+    return mEventQueue.PushLatest(std::move(aEvent), std::move(aListeners),
+                                  aKey, aOptions);
+  }
+  return mEventQueue.Push(std::move(aEvent), std::move(aListeners), aOptions);
+}
+
+ListenerId EventDispatcher::Listen(const char *aEventType,
+                                   EventCallback aEventCallback,
+                                   const ListenerOptions &aOptions) {
+  if (TopicTrie::IsPattern(aEventType)) {
+    return ListenPattern(aEventType, std::move(aEventCallback), aOptions);
+  }
+  return Listen(InternEventId(aEventType), std::move(aEventCallback),
+                aOptions);
+}
+
+ListenerId EventDispatcher::Listen(EventId aEventId,
+                                   EventCallback aEventCallback,
+                                   const ListenerOptions &aOptions) {
+  if (aEventId >= MaxEventIds) {
+    return InvalidListenerId;
+  }
+  Listener listener;
+  if (!MakeListener(std::move(aEventCallback), aOptions, listener)) {
+    return InvalidListenerId;
+  }
+
+  const auto id = listener.mId;
   std::lock_guard<std::mutex> lock(mMutex);
-  const auto eventName = aEvent->GetId();
-  if (mCallbacks.find(eventName) != mCallbacks.end()) {
-    mEventQueue.Push(std::move(aEvent), mCallbacks[eventName]);
+  mExactListeners[aEventId].push_back(std::move(listener));
+  Resolve(aEventId);
+  return id;
+}
+
+bool EventDispatcher::Unlisten(ListenerId aListenerId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (size_t eventId = 0; eventId < MaxEventIds; ++eventId) {
+    auto &listeners = mExactListeners[eventId];
+    for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+      if (it->mId == aListenerId) {
+        listeners.erase(it);
+        Resolve(eventId);
+        return true;
+      }
+    }
+  }
+  for (auto it = mPatternListeners.begin(); it != mPatternListeners.end();
+       ++it) {
+    if (it->mListener.mId == aListenerId) {
+      mPatternListeners.erase(it);
+      CompilePatterns();
+      ResolveAll();
+      return true;
+    }
+  }
+  return false;
+}
+
+void EventDispatcher::SetRecorder(EventRecorder *aRecorder) {
+  mRecorder.store(aRecorder, std::memory_order_release);
+}
+
+bool EventDispatcher::MakeListener(EventCallback aEventCallback,
+                                   const ListenerOptions &aOptions,
+                                   Listener &aListener) {
+  aListener.mId = mNextListenerId.fetch_add(1, std::memory_order_relaxed);
+  if (aOptions.mExecutor) {
+    aListener.mStrand = aOptions.mExecutor->CreateStrand(
+        aListener.mId, std::move(aEventCallback), aOptions.mWorker);
+    return aListener.mStrand != nullptr;
   }
+  aListener.mCallback = std::move(aEventCallback);
+  aListener.mInline = aOptions.mInline;
+  return true;
 }
 
-void EventDispatcher::Listen(std::string aEventType,
-                             std::function<void(Event &)> aEventCallback) {
+ListenerId EventDispatcher::ListenPattern(const char *aPattern,
+                                          EventCallback aEventCallback,
+                                          const ListenerOptions &aOptions) {
+  PatternListener listener{aPattern, Listener()};
+  if (!MakeListener(std::move(aEventCallback), aOptions,
+                    listener.mListener)) {
+    return InvalidListenerId;
+  }
+
+  const auto id = listener.mListener.mId;
   std::lock_guard<std::mutex> lock(mMutex);
-  mCallbacks[aEventType].push_back(aEventCallback);
+  mPatternListeners.push_back(std::move(listener));
+  CompilePatterns();
+  ResolveAll();
+  return id;
+}
+
+void EventDispatcher::CompilePatterns() {
+  mPatterns.Clear();
+  for (size_t i = 0; i < mPatternListeners.size(); ++i) {
+    mPatterns.Insert(mPatternListeners[i].mPattern.c_str(), i);
+  }
+}
+
+void EventDispatcher::Resolve(EventId aEventId) {
+  auto listeners = mExactListeners[aEventId];
+  const auto name = GetEventName(aEventId);
+  if (name && !mPatternListeners.empty()) {
+    mPatterns.Match(name, mMatches);
+    for (const auto index : mMatches) {
+      listeners.push_back(mPatternListeners[index].mListener);
+    }
+  }
+  Publish(aEventId, std::move(listeners));
+}
+
+void EventDispatcher::ResolveAll() {
+  const auto count = GetEventIdCount();
+  for (size_t eventId = 0; eventId < count; ++eventId) {
+    Resolve(eventId);
+  }
+  mResolvedIds.store(count, std::memory_order_release);
+}
+
+void EventDispatcher::ResolveNewIds() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  const auto count = GetEventIdCount();
+  for (auto eventId = mResolvedIds.load(std::memory_order_relaxed);
+       eventId < count; ++eventId) {
+    Resolve(eventId);
+  }
+  mResolvedIds.store(count, std::memory_order_release);
+}
+
+EventDispatcher::ListenerSetSnapshot EventDispatcher::GetListeners(
+    EventId aEventId) const {
+  if (aEventId >= MaxEventIds) {
+    return nullptr;
+  }
+  return std::atomic_load_explicit(&mListeners[aEventId],
+                                   std::memory_order_acquire);
+}
+
+void EventDispatcher::Publish(EventId aEventId, ListenerList aListeners) {
+  auto set = std::make_shared<ListenerSet>();
+  for (const auto &listener : aListeners) {
+    if (listener.mInline) {
+      set->mHasInline = true;
+    } else {
+      set->mQueued.push_back(listener);
+    }
+  }
+  if (!set->mHasInline) {
+    set->mQueued.clear();
+  }
+  set->mAll = std::move(aListeners);
+  std::atomic_store_explicit(&mListeners[aEventId],
+                             ListenerSetSnapshot(std::move(set)),
+                             std::memory_order_release);
 }
-}  // namespace Events
\ No newline at end of file
+}  // namespace Events
@@ -0,0 +1,150 @@
+/**
+ * @file EventExecutor.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventExecutor.hpp"
+
+#include "EventTrace.hpp"
+#include "ScopedThreadConfig.hpp"
+
+namespace Events {
+EventStrand::EventStrand(EventExecutor &aExecutor, ListenerId aListenerId,
+                         EventCallback aCallback, int aWorker, size_t aDepth)
+    : mExecutor(aExecutor),
+      mListenerId(aListenerId),
+      mCallback(std::move(aCallback)),
+      mWorker(aWorker),
+      mPending(aDepth) {}
+
+void EventStrand::Post(const EventRef &aEvent) {
+  if (!mPending.TryPush(EventRef(aEvent))) {
+    mDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (!mScheduled.exchange(true, std::memory_order_acq_rel)) {
+    mExecutor.Schedule(this);
+  }
+}
+
+uint32_t EventStrand::GetDropped() const {
+  return mDropped.load(std::memory_order_relaxed);
+}
+
+void EventStrand::Run() {
+  EventRef event;
+  for (size_t i = 0; i < RunBatch && mPending.TryPop(event); ++i) {
+    Trace::Invoke(mCallback, *event, mListenerId);
+    event = EventRef();
+  }
+  mScheduled.store(false, std::memory_order_release);
+  // Events posted while the batch ran saw mScheduled set and did not
+  // reschedule, so pick them up here
+  if (mPending.Size() > 0 &&
+      !mScheduled.exchange(true, std::memory_order_acq_rel)) {
+    mExecutor.Schedule(this);
+  }
+}
+
+EventExecutor::EventExecutor(size_t aWorkerCount, size_t aMaxStrands)
+    : EventExecutor(nullptr, aWorkerCount, aMaxStrands) {}
+
+EventExecutor EventExecutor::WithCores(std::initializer_list<int> aWorkerCores,
+                                       size_t aMaxStrands) {
+  return EventExecutor(aWorkerCores.begin(), aWorkerCores.size(), aMaxStrands);
+}
+
+EventExecutor::EventExecutor(const int *aWorkerCores, size_t aWorkerCount,
+                             size_t aMaxStrands)
+    : mMaxStrands(aMaxStrands), mReady(aWorkerCount + 1) {
+  mStrands.reserve(mMaxStrands);
+  for (auto &queue : mReady) {
+    queue.mStrands.reset(new EventStrand *[mMaxStrands]);
+  }
+  for (size_t index = 0; index < aWorkerCount; ++index) {
+    StartWorker(index,
+                aWorkerCores != nullptr ? aWorkerCores[index] : NoCoreAffinity);
+  }
+}
+
+EventExecutor::~EventExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopped = true;
+  }
+  mCondition.notify_all();
+  for (auto &worker : mWorkers) {
+    worker.join();
+  }
+}
+
+EventStrand *EventExecutor::CreateStrand(ListenerId aListenerId,
+                                         EventCallback aCallback, int aWorker,
+                                         size_t aDepth) {
+  if (aWorker != ListenerOptions::AnyWorker &&
+      (aWorker < 0 || static_cast<size_t>(aWorker) >= mWorkers.size())) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mStrands.size() == mMaxStrands) {
+    return nullptr;
+  }
+  mStrands.push_back(std::make_unique<EventStrand>(
+      *this, aListenerId, std::move(aCallback), aWorker, aDepth));
+  return mStrands.back().get();
+}
+
+size_t EventExecutor::GetWorkerCount() const { return mWorkers.size(); }
+
+void EventExecutor::Schedule(EventStrand *aStrand) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto &queue = aStrand->mWorker == ListenerOptions::AnyWorker
+                      ? mReady.back()
+                      : mReady[aStrand->mWorker];
+    queue.mStrands[(queue.mHead + queue.mSize) % mMaxStrands] = aStrand;
+    ++queue.mSize;
+  }
+  // Pinned strands need their own worker, so wake every worker rather than
+  // an arbitrary one
+  mCondition.notify_all();
+}
+
+bool EventExecutor::PopReady(ReadyQueue &aQueue, EventStrand *&aStrand) {
+  if (aQueue.mSize == 0) {
+    return false;
+  }
+  aStrand = aQueue.mStrands[aQueue.mHead];
+  aQueue.mHead = (aQueue.mHead + 1) % mMaxStrands;
+  --aQueue.mSize;
+  return true;
+}
+
+void EventExecutor::WorkerLoop(size_t aIndex) {
+  auto &ownQueue = mReady[aIndex];
+  auto &sharedQueue = mReady.back();
+  for (;;) {
+    EventStrand *strand = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [&] {
+        return mStopped || ownQueue.mSize > 0 || sharedQueue.mSize > 0;
+      });
+      if (mStopped) {
+        return;
+      }
+      if (!PopReady(ownQueue, strand)) {
+        PopReady(sharedQueue, strand);
+      }
+    }
+    strand->Run();
+  }
+}
+
+void EventExecutor::StartWorker(size_t aIndex, int aCore) {
+  Common::ScopedThreadConfig config("event_worker", aCore);
+  mWorkers.emplace_back(&EventExecutor::WorkerLoop, this, aIndex);
+}
+}  // namespace Events
@@ -0,0 +1,55 @@
+/**
+ * @file EventId.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventId.hpp"
+
+#include <cstring>
+#include <mutex>
+
+namespace Events {
+namespace {
+struct EventIdRegistry {
+  // Names are copied so callers may intern strings they do not keep
+  char mNames[MaxEventIds][MaxEventNameLength + 1]{};
+  size_t mCount = 0;
+  std::mutex mMutex;
+};
+
+EventIdRegistry &GetRegistry() {
+  static EventIdRegistry registry;
+  return registry;
+}
+}  // namespace
+
+EventId InternEventId(const char *aName) {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  for (size_t i = 0; i < registry.mCount; ++i) {
+    if (std::strcmp(registry.mNames[i], aName) == 0) {
+      return static_cast<EventId>(i);
+    }
+  }
+  if (registry.mCount == MaxEventIds ||
+      std::strlen(aName) > MaxEventNameLength) {
+    return InvalidEventId;
+  }
+  std::strcpy(registry.mNames[registry.mCount], aName);
+  return static_cast<EventId>(registry.mCount++);
+}
+
+const char *GetEventName(EventId aId) {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  return aId < registry.mCount ? registry.mNames[aId] : nullptr;
+}
+
+size_t GetEventIdCount() {
+  auto &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  return registry.mCount;
+}
+}  // namespace Events
@@ -7,27 +7,393 @@
  */
 #include "EventQueue.hpp"
 
+#include "EventExecutor.hpp"
+#include "EventTrace.hpp"
+
 namespace Events {
+namespace {
+// Queue whose callbacks run on this thread. Producing into it with
+// OverflowPolicy::Block would wait for the thread itself.
+thread_local const EventQueue *tConsumerQueue = nullptr;
+
+void UpdateMax(std::atomic<uint32_t> &aMax, uint32_t aValue) {
+  auto max = aMax.load(std::memory_order_relaxed);
+  while (aValue > max &&
+         !aMax.compare_exchange_weak(max, aValue, std::memory_order_relaxed)) {
+  }
+}
+}  // namespace
+
+EventQueue::EventQueue(size_t aCapacity) {
+  for (auto &lane : mLanes) {
+    lane = std::make_unique<Lane>(aCapacity);
+  }
+}
+
 size_t EventQueue::Size() const {
-  std::lock_guard<std::mutex> lock(mMutex);
-  return mQueue.size();
+  auto size = mStagedCount.load(std::memory_order_relaxed);
+  for (const auto &lane : mLanes) {
+    size += lane->Size();
+  }
+  return size;
 }
+
 void EventQueue::Pop() {
-  std::lock_guard<std::mutex> lock(mMutex);
-  if (!mQueue.empty()) {
-    const auto event = std::move(mQueue.front());
-    mQueue.pop();
-    const auto callbacks = event.second;
-    for (const auto &callback : callbacks) {
-      callback(*event.first);
+  DispatchEvent event;
+  if (PopNext(event)) {
+    Invoke(event);
+  }
+}
+
+size_t EventQueue::WaitAndDrain(std::chrono::milliseconds aTimeout) {
+  auto count = Drain();
+  if (count > 0 || mStopped.load()) {
+    return count;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    mConsumerWaiting.store(true);
+    // Pairs with the fence in Notify so a push racing with this check is
+    // either seen here or sees mConsumerWaiting set
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    mWaitCondition.wait_for(lock, aTimeout, [this] {
+      return Size() > 0 || mStopped.load();
+    });
+    mConsumerWaiting.store(false);
+  }
+  return Drain();
+}
+
+void EventQueue::RunLoop() {
+  while (!mStopped.load()) {
+    WaitAndDrain(std::chrono::milliseconds(1000));
+  }
+}
+
+void EventQueue::Stop() {
+  mStopped.store(true);
+  std::lock_guard<std::mutex> lock(mWaitMutex);
+  mWaitCondition.notify_one();
+}
+
+LatencyStats EventQueue::GetLatencyStats() const {
+  return LatencyStats{mLatencyCount.load(std::memory_order_relaxed),
+                      mLatencyTotalUs.load(std::memory_order_relaxed),
+                      mLatencyMaxUs.load(std::memory_order_relaxed)};
+}
+
+DispatchStatus EventQueue::Push(EventPtr aEvent, ListenerSnapshot aListeners,
+                                const DispatchOptions &aOptions) {
+  [[maybe_unused]] const auto eventId = aEvent->GetId();
+  auto &lane = *mLanes[static_cast<size_t>(aOptions.mPriority)];
+  DispatchEvent entry{std::move(aEvent), std::move(aListeners),
+                      std::chrono::steady_clock::now(), nullptr,
+                      aOptions.mDeadline};
+  const auto status = Enqueue(lane, entry, aOptions);
+  if (status != DispatchStatus::Queued &&
+      status != DispatchStatus::DroppedOldest) {
+    return status;
+  }
+  EVENTS_TRACE(Trace::Stage::Push, eventId, InvalidListenerId);
+  EVENTS_TRACE_QUEUE_DEPTH(Size());
+  Notify();
+  return status;
+}
+
+DispatchStatus EventQueue::PushLatest(EventPtr aEvent,
+                                      ListenerSnapshot aListeners,
+                                      uint16_t aKey,
+                                      const DispatchOptions &aOptions) {
+  auto slot = FindSlot(aEvent->GetId(), aKey, aEvent);
+  if (!slot) {
+    return Push(std::move(aEvent), std::move(aListeners), aOptions);
+  }
+
+  [[maybe_unused]] const auto eventId = aEvent->GetId();
+  auto *const raw = aEvent.release();
+  const auto previous = slot->mPending.exchange(raw, std::memory_order_acq_rel);
+  if (previous) {
+    // The queue entry of the previous Event now delivers this one
+    slot->mDeleter(previous);
+    mConflated.fetch_add(1, std::memory_order_relaxed);
+    return DispatchStatus::Conflated;
+  }
+
+  auto &lane = *mLanes[static_cast<size_t>(aOptions.mPriority)];
+  DispatchEvent entry{nullptr, std::move(aListeners),
+                      std::chrono::steady_clock::now(), slot,
+                      aOptions.mDeadline};
+  // Only the first pending Event of a key needs an entry, so a full lane
+  // means other Events are backing up and this one is dropped
+  auto options = aOptions;
+  options.mOverflow = OverflowPolicy::DropNewest;
+  auto status = Enqueue(lane, entry, options);
+  auto *pending = raw;
+  while (status != DispatchStatus::Queued) {
+    // Only clear the slot while it still holds the Event that has no entry
+    if (slot->mPending.compare_exchange_strong(pending, nullptr,
+                                               std::memory_order_acq_rel)) {
+      slot->mDeleter(pending);
+      return status;
     }
+    if (!pending) {
+      return status;
+    }
+    // A later PushLatest replaced the Event and returned Conflated, counting
+    // on this call for the entry, so queue one for it instead
+    status = lane.TryPush(std::move(entry)) ? DispatchStatus::Queued
+                                            : DispatchStatus::Dropped;
   }
+  EVENTS_TRACE(Trace::Stage::Push, eventId, InvalidListenerId);
+  EVENTS_TRACE_QUEUE_DEPTH(Size());
+  Notify();
+  return pending == raw ? status : DispatchStatus::Conflated;
+}
+
+uint32_t EventQueue::GetConflatedCount() const {
+  return mConflated.load(std::memory_order_relaxed);
 }
-void EventQueue::Push(std::unique_ptr<Event> aEvent,
-                      std::vector<std::function<void(Event &)>> &aCallbacks) {
-  std::lock_guard<std::mutex> lock(mMutex);
-  mQueue.push(std::pair<std::unique_ptr<Event>,
-                        std::vector<std::function<void(Event &)>> &>(
-      std::move(aEvent), aCallbacks));
+
+uint32_t EventQueue::GetDeadlineMissCount() const {
+  return mDeadlineMisses.load(std::memory_order_relaxed);
+}
+
+OverflowStats EventQueue::GetOverflowStats() const {
+  return OverflowStats{mDroppedNewest.load(std::memory_order_relaxed),
+                       mDroppedOldest.load(std::memory_order_relaxed),
+                       mTimedOut.load(std::memory_order_relaxed),
+                       mBlocked.load(std::memory_order_relaxed),
+                       mBlockedTotalUs.load(std::memory_order_relaxed),
+                       mBlockedMaxUs.load(std::memory_order_relaxed)};
+}
+
+DispatchStatus EventQueue::Enqueue(Lane &aLane, DispatchEvent &aEntry,
+                                   const DispatchOptions &aOptions) {
+  if (aLane.TryPush(std::move(aEntry))) {
+    return DispatchStatus::Queued;
+  }
+  switch (aOptions.mOverflow) {
+    case OverflowPolicy::Block:
+      return EnqueueBlocking(aLane, aEntry, aOptions.mBlockTimeout);
+    case OverflowPolicy::DropOldest:
+      return EnqueueEvicting(aLane, aEntry);
+    default:
+      mDroppedNewest.fetch_add(1, std::memory_order_relaxed);
+      return DispatchStatus::Dropped;
+  }
+}
+
+DispatchStatus EventQueue::EnqueueBlocking(Lane &aLane, DispatchEvent &aEntry,
+                                           std::chrono::milliseconds aTimeout) {
+  if (tConsumerQueue == this) {
+    // Nothing would drain the lane while this thread waits
+    mDroppedNewest.fetch_add(1, std::memory_order_relaxed);
+    return DispatchStatus::Dropped;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + aTimeout;
+  bool pushed = false;
+  {
+    std::unique_lock<std::mutex> lock(mSpaceMutex);
+    mBlockedProducers.fetch_add(1);
+    // Pairs with the fence in NotifySpace so a pop racing with this push is
+    // either seen here or sees mBlockedProducers set
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!(pushed = aLane.TryPush(std::move(aEntry)))) {
+      if (mSpaceCondition.wait_until(lock, deadline) ==
+          std::cv_status::timeout) {
+        pushed = aLane.TryPush(std::move(aEntry));
+        break;
+      }
+    }
+    mBlockedProducers.fetch_sub(1);
+  }
+
+  const auto blockedUs = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+  mBlocked.fetch_add(1, std::memory_order_relaxed);
+  mBlockedTotalUs.fetch_add(blockedUs, std::memory_order_relaxed);
+  UpdateMax(mBlockedMaxUs, blockedUs);
+  if (!pushed) {
+    mTimedOut.fetch_add(1, std::memory_order_relaxed);
+    return DispatchStatus::TimedOut;
+  }
+  return DispatchStatus::Queued;
+}
+
+DispatchStatus EventQueue::EnqueueEvicting(Lane &aLane,
+                                           DispatchEvent &aEntry) {
+  // Other producers may refill the lane between evicting and pushing, give up
+  // after a lap of the ring rather than spin
+  for (size_t i = 0; i < aLane.Capacity(); ++i) {
+    DispatchEvent oldest;
+    if (aLane.TryPop(oldest)) {
+      Discard(oldest);
+      mDroppedOldest.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (aLane.TryPush(std::move(aEntry))) {
+      return DispatchStatus::DroppedOldest;
+    }
+  }
+  mDroppedNewest.fetch_add(1, std::memory_order_relaxed);
+  return DispatchStatus::Dropped;
+}
+
+void EventQueue::Discard(DispatchEvent &aEntry) {
+  if (aEntry.mSlot) {
+    const auto pending =
+        aEntry.mSlot->mPending.exchange(nullptr, std::memory_order_acq_rel);
+    if (pending) {
+      aEntry.mSlot->mDeleter(pending);
+    }
+  }
+  aEntry = DispatchEvent();
+}
+
+void EventQueue::NotifySpace() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mBlockedProducers.load() > 0) {
+    std::lock_guard<std::mutex> lock(mSpaceMutex);
+    mSpaceCondition.notify_all();
+  }
+}
+
+ConflationSlot *EventQueue::FindSlot(EventId aId, uint16_t aKey,
+                                     const EventPtr &aEvent) {
+  // Zero marks a free slot, so offset the ID by one
+  const uint32_t key = ((static_cast<uint32_t>(aId) + 1) << 16) | aKey;
+  for (auto &slot : mSlots) {
+    auto current = slot.mKey.load(std::memory_order_acquire);
+    while (current == ClaimingSlot) {
+      current = slot.mKey.load(std::memory_order_acquire);
+    }
+    if (current == key) {
+      return &slot;
+    }
+    if (current == 0 &&
+        slot.mKey.compare_exchange_strong(current, ClaimingSlot,
+                                          std::memory_order_acquire)) {
+      slot.mDeleter = aEvent.get_deleter();
+      slot.mKey.store(key, std::memory_order_release);
+      return &slot;
+    }
+    // Lost the race for a free slot, it may have been claimed for this key
+    while (current == ClaimingSlot) {
+      current = slot.mKey.load(std::memory_order_acquire);
+    }
+    if (current == key) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+bool EventQueue::PopNext(DispatchEvent &aEvent) {
+  for (size_t i = 0; i < LaneCount; ++i) {
+    auto &staged = mStaged[i];
+    if (!staged.mValid && mLanes[i]->TryPop(staged.mEvent)) {
+      staged.mValid = true;
+      mStagedCount.fetch_add(1, std::memory_order_relaxed);
+      NotifySpace();
+    }
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  StagedEvent *next = nullptr;
+  for (auto &staged : mStaged) {
+    if (!staged.mValid) {
+      continue;
+    }
+    if (staged.mSkips >= MaxSkips) {
+      // Starving lane, serve it regardless of priority
+      next = &staged;
+      break;
+    }
+    if (!next) {
+      next = &staged;
+    } else if (staged.mEvent.mDeadline - DeadlineSlack <= now &&
+               staged.mEvent.mDeadline < next->mEvent.mDeadline) {
+      // Urgent deadline in a lower lane
+      next = &staged;
+    }
+  }
+  if (!next) {
+    return false;
+  }
+
+  for (auto &staged : mStaged) {
+    if (staged.mValid && &staged != next) {
+      ++staged.mSkips;
+    }
+  }
+  aEvent = std::move(next->mEvent);
+  next->mEvent = DispatchEvent();
+  next->mValid = false;
+  next->mSkips = 0;
+  mStagedCount.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+size_t EventQueue::Drain() {
+  size_t count = 0;
+  DispatchEvent event;
+  while (PopNext(event)) {
+    Invoke(event);
+    ++count;
+  }
+  return count;
+}
+
+void EventQueue::Invoke(DispatchEvent &aEvent) {
+  const auto now = std::chrono::steady_clock::now();
+  if (now > aEvent.mDeadline) {
+    mDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+  }
+  const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                           now - aEvent.mDispatchTime)
+                           .count();
+  mLatencyCount.fetch_add(1, std::memory_order_relaxed);
+  mLatencyTotalUs.fetch_add(latency, std::memory_order_relaxed);
+  if (latency > mLatencyMaxUs.load(std::memory_order_relaxed)) {
+    mLatencyMaxUs.store(latency, std::memory_order_relaxed);
+  }
+
+  if (aEvent.mSlot) {
+    aEvent.mEvent = EventPtr(
+        aEvent.mSlot->mPending.exchange(nullptr, std::memory_order_acq_rel),
+        aEvent.mSlot->mDeleter);
+    if (!aEvent.mEvent) {
+      aEvent = DispatchEvent();
+      return;
+    }
+  }
+
+  EventRef event(std::move(aEvent.mEvent));
+  [[maybe_unused]] const auto eventId = event->GetId();
+  const auto outerQueue = tConsumerQueue;
+  tConsumerQueue = this;
+  EVENTS_TRACE(Trace::Stage::Pop, eventId, InvalidListenerId);
+  EVENTS_TRACE_QUEUE_LATENCY(eventId, latency);
+  for (const auto &listener : *aEvent.mListeners) {
+    if (listener.mStrand) {
+      listener.mStrand->Post(event);
+      continue;
+    }
+    Trace::Invoke(listener.mCallback, *event, listener.mId);
+  }
+  tConsumerQueue = outerQueue;
+  aEvent = DispatchEvent();
+}
+
+void EventQueue::Notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mConsumerWaiting.load()) {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mWaitCondition.notify_one();
+  }
 }
-}  // namespace Events
\ No newline at end of file
+}  // namespace Events
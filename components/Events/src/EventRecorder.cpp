@@ -0,0 +1,169 @@
+/**
+ * @file EventRecorder.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventRecorder.hpp"
+
+#include <cstring>
+
+#include "EventId.hpp"
+#include "EventTrace.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#endif
+
+namespace Events {
+EventRecorder::EventRecorder(size_t aCapacity)
+    : mCapacity(aCapacity), mBuffer(new uint8_t[aCapacity]) {}
+
+void EventRecorder::Record(const Event &aEvent) {
+  uint8_t record[RecordHeaderSize + MaxPayloadSize];
+  const auto payloadSize = aEvent.Serialize(record + RecordHeaderSize,
+                                            MaxPayloadSize);
+  record[4] = aEvent.GetId();
+  record[5] = static_cast<uint8_t>(payloadSize);
+  const auto size = RecordHeaderSize + payloadSize;
+  if (payloadSize > MaxPayloadSize || size > mCapacity) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  // Timestamp under the lock so records are in time order
+  const auto time = Trace::NowUs();
+  for (size_t i = 0; i < 4; ++i) {
+    record[i] = static_cast<uint8_t>(time >> (8 * i));
+  }
+  // Drop whole records from the tail until the new one fits
+  while (mHead - mTail + size > mCapacity) {
+    mTail += RecordHeaderSize + ByteAt(mTail + 5);
+    ++mOverwritten;
+  }
+  Append(record, size);
+  ++mRecorded;
+}
+
+bool EventRecorder::Flush(const RecordSink &aSink) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return FlushLocked(aSink);
+}
+
+#ifdef ESP_PLATFORM
+bool EventRecorder::FlushToPartition(const char *aLabel) {
+  const auto partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, aLabel);
+  if (!partition) {
+    return false;
+  }
+
+  // Copy the records out so Record is not blocked for the whole erase and
+  // write, which take tens of milliseconds per sector
+  std::unique_ptr<uint8_t[]> records;
+  size_t recordsSize = 0;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    recordsSize = mHead - mTail;
+    records.reset(new uint8_t[recordsSize > 0 ? recordsSize : 1]);
+    const auto start = mTail % mCapacity;
+    const auto first =
+        recordsSize < mCapacity - start ? recordsSize : mCapacity - start;
+    std::memcpy(records.get(), &mBuffer[start], first);
+    std::memcpy(records.get() + first, &mBuffer[0], recordsSize - first);
+  }
+
+  // Count the stream first, the partition has to be erased before writing
+  size_t size = recordsSize;
+  WriteHeader(
+      [&size](const uint8_t *, size_t aSize) {
+        size += aSize;
+        return true;
+      },
+      recordsSize);
+  const auto eraseSize =
+      (size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+  if (eraseSize > partition->size ||
+      esp_partition_erase_range(partition, 0, eraseSize) != ESP_OK) {
+    return false;
+  }
+  size_t offset = 0;
+  const RecordSink write = [partition, &offset](const uint8_t *aData,
+                                                size_t aSize) {
+    if (esp_partition_write(partition, offset, aData, aSize) != ESP_OK) {
+      return false;
+    }
+    offset += aSize;
+    return true;
+  };
+  return WriteHeader(write, recordsSize) &&
+         (recordsSize == 0 || write(records.get(), recordsSize));
+}
+#endif
+
+void EventRecorder::Clear() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mTail = mHead;
+}
+
+RecorderStats EventRecorder::GetStats() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return RecorderStats{mRecorded, mOverwritten, mHead - mTail};
+}
+
+bool EventRecorder::WriteHeader(const RecordSink &aSink,
+                                size_t aRecordsSize) {
+  uint8_t recordsSize[StreamSizeBytes];
+  for (size_t i = 0; i < StreamSizeBytes; ++i) {
+    recordsSize[i] = static_cast<uint8_t>(aRecordsSize >> (8 * i));
+  }
+  const auto count = static_cast<uint8_t>(GetEventIdCount());
+  if (!aSink(StreamMagic, sizeof(StreamMagic)) ||
+      !aSink(recordsSize, sizeof(recordsSize)) || !aSink(&count, 1)) {
+    return false;
+  }
+  for (EventId id = 0; id < count; ++id) {
+    auto name = GetEventName(id);
+    // An ID counted but not yet named by a concurrent InternEventId
+    if (!name) {
+      name = "";
+    }
+    const auto length = static_cast<uint8_t>(std::strlen(name));
+    if (!aSink(&length, 1) ||
+        !aSink(reinterpret_cast<const uint8_t *>(name), length)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EventRecorder::FlushLocked(const RecordSink &aSink) {
+  const auto size = mHead - mTail;
+  if (!WriteHeader(aSink, size)) {
+    return false;
+  }
+
+  // The records are already in stream format, write the ring as at most two
+  // contiguous chunks
+  const auto start = mTail % mCapacity;
+  const auto first = size < mCapacity - start ? size : mCapacity - start;
+  if (first > 0 && !aSink(&mBuffer[start], first)) {
+    return false;
+  }
+  return size == first || aSink(&mBuffer[0], size - first);
+}
+
+void EventRecorder::Append(const uint8_t *aData, size_t aSize) {
+  const auto start = mHead % mCapacity;
+  const auto first = aSize < mCapacity - start ? aSize : mCapacity - start;
+  std::memcpy(&mBuffer[start], aData, first);
+  std::memcpy(&mBuffer[0], aData + first, aSize - first);
+  mHead += aSize;
+}
+
+uint8_t EventRecorder::ByteAt(size_t aPosition) const {
+  return mBuffer[aPosition % mCapacity];
+}
+}  // namespace Events
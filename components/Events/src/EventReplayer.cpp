@@ -0,0 +1,122 @@
+/**
+ * @file EventReplayer.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventReplayer.hpp"
+
+#include <cstring>
+#include <thread>
+
+#include "EventRecorder.hpp"
+
+namespace Events {
+EventReplayer::EventReplayer(EventDispatcher &aDispatcher)
+    : mDispatcher(aDispatcher) {}
+
+void EventReplayer::AddDecoder(const char *aEventId, EventDecoder aDecoder) {
+  mDecoders.push_back(Decoder{aEventId, aDecoder});
+}
+
+bool EventReplayer::Replay(const uint8_t *aStream, size_t aSize,
+                           ReplaySpeed aSpeed, ReplayStats &aStats) {
+  aStats = ReplayStats{};
+  size_t pos = sizeof(EventRecorder::StreamMagic);
+  if (aSize < pos + EventRecorder::StreamSizeBytes + 1 ||
+      std::memcmp(aStream, EventRecorder::StreamMagic,
+                  sizeof(EventRecorder::StreamMagic))) {
+    return false;
+  }
+  size_t recordsSize = 0;
+  for (size_t i = 0; i < EventRecorder::StreamSizeBytes; ++i) {
+    recordsSize |= static_cast<size_t>(aStream[pos++]) << (8 * i);
+  }
+
+  // Decoders indexed by the EventIds of the recording device
+  EventDecoder decoders[MaxEventIds] = {};
+  const auto count = aStream[pos++];
+  for (size_t id = 0; id < count; ++id) {
+    if (pos >= aSize || pos + 1 + aStream[pos] > aSize) {
+      return false;
+    }
+    const auto length = aStream[pos];
+    if (id < MaxEventIds) {
+      decoders[id] = FindDecoder(&aStream[pos + 1], length);
+    }
+    pos += 1 + length;
+  }
+  // Anything after the records, e.g. erased flash, is not part of the stream
+  if (recordsSize > aSize - pos) {
+    return false;
+  }
+  const auto end = pos + recordsSize;
+
+  DispatchOptions options;
+  if (aSpeed == ReplaySpeed::AsFastAsPossible) {
+    options.mOverflow = OverflowPolicy::Block;
+    options.mBlockTimeout = FastReplayBlockTimeout;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  uint32_t previousUs = 0;
+  while (pos < end) {
+    if (pos + EventRecorder::RecordHeaderSize > end) {
+      return false;
+    }
+    const auto record = &aStream[pos];
+    uint32_t timeUs = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      timeUs |= static_cast<uint32_t>(record[i]) << (8 * i);
+    }
+    const auto id = record[4];
+    const auto payloadSize = record[5];
+    pos += EventRecorder::RecordHeaderSize + payloadSize;
+    if (pos > end) {
+      return false;
+    }
+
+    if (aStats.mRecords++ == 0) {
+      previousUs = timeUs;
+    }
+    // Unsigned differences unwrap the 32 bit timestamps
+    aStats.mRecordedUs += static_cast<uint32_t>(timeUs - previousUs);
+    previousUs = timeUs;
+
+    const auto decode = id < MaxEventIds ? decoders[id] : nullptr;
+    auto event = decode ? decode(record + EventRecorder::RecordHeaderSize,
+                                 payloadSize)
+                        : nullptr;
+    if (!event) {
+      ++aStats.mUndecoded;
+      continue;
+    }
+    if (aSpeed == ReplaySpeed::Recorded) {
+      std::this_thread::sleep_until(
+          start + std::chrono::microseconds(aStats.mRecordedUs));
+    }
+    const auto status = mDispatcher.Dispatch(std::move(event), options);
+    if (status == DispatchStatus::Dropped ||
+        status == DispatchStatus::TimedOut) {
+      ++aStats.mDropped;
+    } else {
+      ++aStats.mDispatched;
+    }
+  }
+  aStats.mReplayUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  return true;
+}
+
+EventDecoder EventReplayer::FindDecoder(const uint8_t *aName,
+                                        size_t aLength) const {
+  for (const auto &decoder : mDecoders) {
+    if (std::strlen(decoder.mEventId) == aLength &&
+        std::memcmp(decoder.mEventId, aName, aLength) == 0) {
+      return decoder.mDecode;
+    }
+  }
+  return nullptr;
+}
+}  // namespace Events
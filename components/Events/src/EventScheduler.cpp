@@ -0,0 +1,309 @@
+/**
+ * @file EventScheduler.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventScheduler.hpp"
+
+#include "ScopedThreadConfig.hpp"
+
+namespace Events {
+namespace {
+constexpr std::chrono::milliseconds Minute{60000};
+constexpr std::chrono::seconds WakeupWindow{1};
+}  // namespace
+
+EventScheduler::EventScheduler(size_t aMaxTimers)
+    : mTimers(aMaxTimers < NoTimer ? aMaxTimers : NoTimer - 1),
+      mStart(std::chrono::steady_clock::now()),
+      mWindowStart(mStart) {
+  for (size_t i = 0; i < mTimers.size(); ++i) {
+    mTimers[i].mNext = i + 1 < mTimers.size() ? i + 1 : NoTimer;
+  }
+  mFree = mTimers.empty() ? NoTimer : 0;
+  for (auto &slot : mLevel0) {
+    slot = NoTimer;
+  }
+  for (size_t i = 0; i < LevelSize; ++i) {
+    mLevel1[i] = NoTimer;
+    mLevel2[i] = NoTimer;
+  }
+  Common::ScopedThreadConfig config("event_timer");
+  mThread = std::thread(&EventScheduler::ThreadLoop, this);
+}
+
+EventScheduler::~EventScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopped = true;
+  }
+  mCondition.notify_one();
+  mThread.join();
+}
+
+TimerHandle EventScheduler::ScheduleOnce(std::chrono::milliseconds aDelay,
+                                         TimerCallback aCallback) {
+  return Arm(ToTicks(aDelay), 0, false, std::move(aCallback));
+}
+
+TimerHandle EventScheduler::SchedulePeriodic(std::chrono::milliseconds aPeriod,
+                                             TimerCallback aCallback) {
+  auto period = ToTicks(aPeriod);
+  period = period > 0 ? period : 1;
+  return Arm(period, period, false, std::move(aCallback));
+}
+
+TimerHandle EventScheduler::ScheduleAtNextMinute(TimerCallback aCallback,
+                                                 bool aRepeat) {
+  return Arm(TicksToNextMinute(), aRepeat ? 1 : 0, true, std::move(aCallback));
+}
+
+bool EventScheduler::Cancel(TimerHandle aHandle) {
+  const auto index = static_cast<uint16_t>((aHandle & 0xFFFF) - 1);
+  const auto generation = static_cast<uint16_t>(aHandle >> 16);
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (aHandle == InvalidTimerHandle || index >= mTimers.size()) {
+    return false;
+  }
+  auto &timer = mTimers[index];
+  if (timer.mGeneration != generation) {
+    return false;
+  }
+  switch (timer.mState) {
+    case TimerState::Armed:
+      Unlink(index);
+      Release(index);
+      UpdateNextExpiry();
+      return true;
+    case TimerState::Firing:
+      // Released by RunExpired once the Callback returns
+      timer.mState = TimerState::Cancelled;
+      return true;
+    default:
+      return false;
+  }
+}
+
+SchedulerStats EventScheduler::GetStats() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return SchedulerStats{mWakeups, mFired, mArmed, mWakeupsPerSecond};
+}
+
+TimerHandle EventScheduler::Arm(uint64_t aDelay, uint64_t aPeriod,
+                                bool aMinuteAligned, TimerCallback aCallback) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mFree == NoTimer) {
+    return InvalidTimerHandle;
+  }
+  const auto index = mFree;
+  auto &timer = mTimers[index];
+  mFree = timer.mNext;
+
+  const auto expiry = TickAfter(aDelay);
+  timer.mCallback = std::move(aCallback);
+  // The slot of mCurrentTick was already processed
+  timer.mExpiry = expiry > mCurrentTick ? expiry : mCurrentTick + 1;
+  timer.mPeriod = aPeriod;
+  timer.mMinuteAligned = aMinuteAligned;
+  timer.mState = TimerState::Armed;
+  Insert(index);
+  ++mArmed;
+
+  if (timer.mExpiry < mNextExpiry) {
+    mNextExpiry = timer.mExpiry;
+    mChanged = true;
+    mCondition.notify_one();
+  }
+  return static_cast<TimerHandle>(timer.mGeneration) << 16 | (index + 1u);
+}
+
+void EventScheduler::Insert(uint16_t aIndex) {
+  const auto expiry = mTimers[aIndex].mExpiry;
+  const auto delta = expiry - mCurrentTick;
+  if (delta < Level0Size) {
+    Link(aIndex, &mLevel0[expiry & (Level0Size - 1)]);
+  } else if (delta < Level0Size * LevelSize) {
+    Link(aIndex, &mLevel1[(expiry >> Level0Bits) & (LevelSize - 1)]);
+  } else {
+    // Timers beyond the wheel span wait in the last level 2 slot and are
+    // re-inserted from their real expiry when it cascades
+    const auto slotExpiry =
+        delta < WheelSpan ? expiry : mCurrentTick + WheelSpan - 1;
+    Link(aIndex, &mLevel2[(slotExpiry >> (Level0Bits + LevelBits)) &
+                          (LevelSize - 1)]);
+  }
+}
+
+void EventScheduler::Link(uint16_t aIndex, uint16_t *aSlot) {
+  auto &timer = mTimers[aIndex];
+  timer.mSlot = aSlot;
+  timer.mPrev = NoTimer;
+  timer.mNext = *aSlot;
+  if (*aSlot != NoTimer) {
+    mTimers[*aSlot].mPrev = aIndex;
+  }
+  *aSlot = aIndex;
+}
+
+void EventScheduler::Unlink(uint16_t aIndex) {
+  auto &timer = mTimers[aIndex];
+  if (timer.mPrev != NoTimer) {
+    mTimers[timer.mPrev].mNext = timer.mNext;
+  } else {
+    *timer.mSlot = timer.mNext;
+  }
+  if (timer.mNext != NoTimer) {
+    mTimers[timer.mNext].mPrev = timer.mPrev;
+  }
+  timer.mSlot = nullptr;
+  timer.mNext = NoTimer;
+  timer.mPrev = NoTimer;
+}
+
+void EventScheduler::Release(uint16_t aIndex) {
+  auto &timer = mTimers[aIndex];
+  timer.mCallback = nullptr;
+  timer.mState = TimerState::Free;
+  // Handles of the old timer no longer match
+  ++timer.mGeneration;
+  timer.mNext = mFree;
+  mFree = aIndex;
+  --mArmed;
+}
+
+void EventScheduler::Cascade(uint16_t *aSlot) {
+  auto index = *aSlot;
+  *aSlot = NoTimer;
+  while (index != NoTimer) {
+    const auto next = mTimers[index].mNext;
+    Insert(index);
+    index = next;
+  }
+}
+
+void EventScheduler::Advance(uint64_t aTick) {
+  while (mCurrentTick < aTick) {
+    ++mCurrentTick;
+    const auto slot = mCurrentTick & (Level0Size - 1);
+    if (slot == 0) {
+      const auto slot1 = (mCurrentTick >> Level0Bits) & (LevelSize - 1);
+      if (slot1 == 0) {
+        Cascade(&mLevel2[(mCurrentTick >> (Level0Bits + LevelBits)) &
+                         (LevelSize - 1)]);
+      }
+      Cascade(&mLevel1[slot1]);
+    }
+    while (mLevel0[slot] != NoTimer) {
+      const auto index = mLevel0[slot];
+      Unlink(index);
+      Link(index, &mExpired);
+    }
+  }
+}
+
+void EventScheduler::RunExpired(std::unique_lock<std::mutex> &aLock) {
+  while (mExpired != NoTimer) {
+    const auto index = mExpired;
+    auto &timer = mTimers[index];
+    Unlink(index);
+    timer.mState = TimerState::Firing;
+    // Firing timers are never released or re-armed by other threads, so the
+    // Callback is safe to run unlocked
+    aLock.unlock();
+    timer.mCallback();
+    aLock.lock();
+    ++mFired;
+    if (timer.mState == TimerState::Cancelled || timer.mPeriod == 0) {
+      Release(index);
+    } else {
+      Rearm(index);
+    }
+  }
+  UpdateNextExpiry();
+}
+
+void EventScheduler::Rearm(uint16_t aIndex) {
+  auto &timer = mTimers[aIndex];
+  if (timer.mMinuteAligned) {
+    timer.mExpiry = TickAfter(TicksToNextMinute());
+  } else {
+    timer.mExpiry += timer.mPeriod;
+  }
+  if (timer.mExpiry <= mCurrentTick) {
+    // Skip the periods missed while the Callback ran late
+    const auto missed = (mCurrentTick - timer.mExpiry) / timer.mPeriod + 1;
+    timer.mExpiry += missed * timer.mPeriod;
+  }
+  timer.mState = TimerState::Armed;
+  Insert(aIndex);
+}
+
+void EventScheduler::UpdateNextExpiry() {
+  mNextExpiry = UINT64_MAX;
+  for (const auto &timer : mTimers) {
+    if (timer.mState == TimerState::Armed && timer.mExpiry < mNextExpiry) {
+      mNextExpiry = timer.mExpiry;
+    }
+  }
+}
+
+void EventScheduler::CountWakeup() {
+  ++mWakeups;
+  ++mWindowWakeups;
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = now - mWindowStart;
+  if (elapsed >= WakeupWindow) {
+    mWakeupsPerSecond =
+        mWindowWakeups / std::chrono::duration<float>(elapsed).count();
+    mWindowWakeups = 0;
+    mWindowStart = now;
+  }
+}
+
+void EventScheduler::ThreadLoop() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (!mStopped) {
+    mChanged = false;
+    const auto woken = [this] { return mStopped || mChanged; };
+    if (mNextExpiry == UINT64_MAX) {
+      mCondition.wait(lock, woken);
+    } else {
+      mCondition.wait_until(lock, mStart + TickPeriod * mNextExpiry, woken);
+    }
+    if (mStopped) {
+      return;
+    }
+    CountWakeup();
+    Advance(NowTick());
+    RunExpired(lock);
+  }
+}
+
+uint64_t EventScheduler::NowTick() const {
+  return (std::chrono::steady_clock::now() - mStart) / TickPeriod;
+}
+
+uint64_t EventScheduler::TickAfter(uint64_t aDelay) const {
+  // Round up so a timer never expires before its full delay has passed
+  const auto elapsed = std::chrono::steady_clock::now() - mStart;
+  return (elapsed + TickPeriod - std::chrono::steady_clock::duration(1)) /
+             TickPeriod +
+         aDelay;
+}
+
+uint64_t EventScheduler::ToTicks(std::chrono::milliseconds aDuration) {
+  if (aDuration.count() <= 0) {
+    return 0;
+  }
+  return (aDuration + TickPeriod - std::chrono::milliseconds(1)) / TickPeriod;
+}
+
+uint64_t EventScheduler::TicksToNextMinute() {
+  const auto sinceEpoch =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch());
+  return ToTicks(Minute - sinceEpoch % Minute);
+}
+}  // namespace Events
@@ -0,0 +1,347 @@
+/**
+ * @file EventTrace.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "EventTrace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
+namespace Events {
+namespace Trace {
+uint32_t NowUs() {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+#ifdef EVENTS_TRACING
+namespace {
+static constexpr size_t BucketCount = 20;
+static constexpr size_t MaxTracedListeners = 32;
+static constexpr size_t ThreadRingSize = 64;
+
+// Bucket i counts samples below 2^i microseconds, the last bucket everything
+// above
+class Histogram {
+ public:
+  void Add(uint32_t aUs) {
+    size_t bucket = 0;
+    while (bucket < BucketCount - 1 && aUs >= (1u << bucket)) {
+      ++bucket;
+    }
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    auto max = mMaxUs.load(std::memory_order_relaxed);
+    while (aUs > max && !mMaxUs.compare_exchange_weak(
+                            max, aUs, std::memory_order_relaxed)) {
+    }
+  }
+
+  LatencySummary Summarize() const {
+    LatencySummary summary{mCount.load(std::memory_order_relaxed), 0, 0,
+                           mMaxUs.load(std::memory_order_relaxed)};
+    const auto p50 = (summary.mCount + 1) / 2;
+    const auto p99 = summary.mCount - summary.mCount / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < BucketCount && summary.mCount > 0; ++i) {
+      seen += mBuckets[i].load(std::memory_order_relaxed);
+      const auto bound = i < BucketCount - 1 && (1u << i) < summary.mMaxUs
+                             ? (1u << i)
+                             : summary.mMaxUs;
+      if (summary.mP50Us == 0 && seen >= p50) {
+        summary.mP50Us = bound;
+      }
+      if (seen >= p99) {
+        summary.mP99Us = bound;
+        break;
+      }
+    }
+    return summary;
+  }
+
+  void Reset() {
+    for (auto &bucket : mBuckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    mCount.store(0, std::memory_order_relaxed);
+    mMaxUs.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint32_t> mBuckets[BucketCount]{};
+  std::atomic<uint32_t> mCount{0};
+  std::atomic<uint32_t> mMaxUs{0};
+};
+
+struct ListenerHistogram {
+  std::atomic<ListenerId> mId{InvalidListenerId};
+  Histogram mHistogram;
+};
+
+// One record of a ring. The fields are written with relaxed stores between
+// two stores of mSequence, so a reader can tell a torn or overwritten slot
+// from the record it expected.
+struct TraceSlot {
+  // 2 * index + 1 while record index is written, 2 * index + 2 once done
+  std::atomic<uint32_t> mSequence{0};
+  std::atomic<uint32_t> mTimeUs{0};
+  // Stage in the high byte, EventId in the low byte
+  std::atomic<uint32_t> mTag{0};
+  std::atomic<ListenerId> mListenerId{InvalidListenerId};
+};
+
+// Written only by the thread that claimed it, so the hot path takes no lock.
+// Indexes are never reset, a claim moves mStart past the previous owner's
+// records instead, so a slot's sequence is never ambiguous.
+struct ThreadRing {
+  std::atomic<bool> mClaimed{false};
+  // Index of the next record to write
+  std::atomic<uint32_t> mWriteIndex{0};
+  // Index of the owning thread's first record
+  std::atomic<uint32_t> mStart{0};
+  TraceSlot mSlots[ThreadRingSize];
+};
+
+Histogram sQueueLatency[MaxEventIds];
+ListenerHistogram sListenerLatency[MaxTracedListeners];
+std::atomic<size_t> sQueueHighWater{0};
+ThreadRing sThreadRings[MaxTracedThreads];
+
+// Claims a ring on a thread's first record and releases it when the thread
+// exits
+class RingHandle {
+ public:
+  ~RingHandle() {
+    if (mRing) {
+      mRing->mClaimed.store(false, std::memory_order_release);
+    }
+  }
+
+  ThreadRing *Get() {
+    if (mRing) {
+      return mRing;
+    }
+    for (auto &ring : sThreadRings) {
+      if (!ring.mClaimed.exchange(true, std::memory_order_acquire)) {
+        ring.mStart.store(ring.mWriteIndex.load(std::memory_order_relaxed),
+                          std::memory_order_release);
+        mRing = &ring;
+        break;
+      }
+    }
+    return mRing;
+  }
+
+ private:
+  ThreadRing *mRing = nullptr;
+};
+
+thread_local RingHandle tRing;
+
+// Copies the newest records that are not overwritten while being read,
+// oldest first, without blocking the owning thread
+size_t CopyRecords(const ThreadRing &aRing, TraceRecord *aRecords,
+                   size_t aMaxRecords) {
+  const auto start = aRing.mStart.load(std::memory_order_acquire);
+  const auto end = aRing.mWriteIndex.load(std::memory_order_acquire);
+  size_t count = end - start;
+  count = count < ThreadRingSize ? count : ThreadRingSize;
+  count = count < aMaxRecords ? count : aMaxRecords;
+  size_t copied = 0;
+  for (auto index = end - static_cast<uint32_t>(count); index != end;
+       ++index) {
+    const auto &slot = aRing.mSlots[index % ThreadRingSize];
+    const auto sequence = slot.mSequence.load(std::memory_order_acquire);
+    const auto time = slot.mTimeUs.load(std::memory_order_relaxed);
+    const auto tag = slot.mTag.load(std::memory_order_relaxed);
+    const auto listenerId = slot.mListenerId.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Skip a record the owner lapped or is rewriting, only the oldest ones
+    // can be
+    if (sequence != 2 * index + 2 ||
+        slot.mSequence.load(std::memory_order_relaxed) != sequence) {
+      continue;
+    }
+    aRecords[copied++] =
+        TraceRecord{time, static_cast<Stage>(tag >> 8),
+                    static_cast<EventId>(tag & 0xFF), listenerId};
+  }
+  return copied;
+}
+
+Histogram *FindListener(ListenerId aListenerId, bool aClaim) {
+  for (auto &entry : sListenerLatency) {
+    auto id = entry.mId.load(std::memory_order_acquire);
+    if (id == aListenerId) {
+      return &entry.mHistogram;
+    }
+    if (id == InvalidListenerId && aClaim &&
+        entry.mId.compare_exchange_strong(id, aListenerId,
+                                          std::memory_order_acq_rel)) {
+      return &entry.mHistogram;
+    }
+    // A failed claim reloads id, another thread may have claimed this entry
+    // for the same listener
+    if (id == aListenerId) {
+      return &entry.mHistogram;
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+void Record(Stage aStage, EventId aEventId, ListenerId aListenerId) {
+  const auto ring = tRing.Get();
+  if (!ring) {
+    return;
+  }
+  // Only this thread writes the ring
+  const auto index = ring->mWriteIndex.load(std::memory_order_relaxed);
+  auto &slot = ring->mSlots[index % ThreadRingSize];
+  slot.mSequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.mTimeUs.store(NowUs(), std::memory_order_relaxed);
+  slot.mTag.store(static_cast<uint32_t>(aStage) << 8 | aEventId,
+                  std::memory_order_relaxed);
+  slot.mListenerId.store(aListenerId, std::memory_order_relaxed);
+  slot.mSequence.store(2 * index + 2, std::memory_order_release);
+  ring->mWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+void RecordQueueLatency(EventId aEventId, uint32_t aLatencyUs) {
+  if (aEventId < MaxEventIds) {
+    sQueueLatency[aEventId].Add(aLatencyUs);
+  }
+}
+
+void RecordListenerLatency(ListenerId aListenerId, uint32_t aLatencyUs) {
+  auto histogram = FindListener(aListenerId, true);
+  if (histogram) {
+    histogram->Add(aLatencyUs);
+  }
+}
+
+void RecordQueueDepth(size_t aDepth) {
+  auto highWater = sQueueHighWater.load(std::memory_order_relaxed);
+  while (aDepth > highWater &&
+         !sQueueHighWater.compare_exchange_weak(highWater, aDepth,
+                                                std::memory_order_relaxed)) {
+  }
+}
+
+LatencySummary GetQueueLatency(EventId aEventId) {
+  if (aEventId >= MaxEventIds) {
+    return LatencySummary{};
+  }
+  return sQueueLatency[aEventId].Summarize();
+}
+
+LatencySummary GetListenerLatency(ListenerId aListenerId) {
+  const auto histogram = FindListener(aListenerId, false);
+  return histogram ? histogram->Summarize() : LatencySummary{};
+}
+
+size_t GetQueueHighWater() {
+  return sQueueHighWater.load(std::memory_order_relaxed);
+}
+
+size_t GetThreadRecords(TraceRecord *aRecords, size_t aMaxRecords) {
+  const auto ring = tRing.Get();
+  return ring ? CopyRecords(*ring, aRecords, aMaxRecords) : 0;
+}
+
+size_t GetThreadRecords(size_t aThreadIndex, TraceRecord *aRecords,
+                        size_t aMaxRecords) {
+  if (aThreadIndex >= MaxTracedThreads) {
+    return 0;
+  }
+  return CopyRecords(sThreadRings[aThreadIndex], aRecords, aMaxRecords);
+}
+
+size_t GetThreadIndex() {
+  const auto ring = tRing.Get();
+  return ring ? static_cast<size_t>(ring - sThreadRings) : MaxTracedThreads;
+}
+
+void WriteJson(std::FILE *aOut) {
+  std::fprintf(aOut, "{\"queue_high_water\":%zu,\"events\":[",
+               GetQueueHighWater());
+  const char *separator = "";
+  for (EventId id = 0; id < MaxEventIds; ++id) {
+    const auto summary = sQueueLatency[id].Summarize();
+    if (summary.mCount == 0) {
+      continue;
+    }
+    const auto name = GetEventName(id);
+    std::fprintf(aOut,
+                 "%s{\"id\":%u,\"name\":\"%s\",\"count\":%" PRIu32
+                 ",\"p50_us\":%" PRIu32 ",\"p99_us\":%" PRIu32
+                 ",\"max_us\":%" PRIu32 "}",
+                 separator, id, name ? name : "", summary.mCount,
+                 summary.mP50Us, summary.mP99Us, summary.mMaxUs);
+    separator = ",";
+  }
+  std::fprintf(aOut, "],\"listeners\":[");
+  separator = "";
+  for (const auto &entry : sListenerLatency) {
+    const auto id = entry.mId.load(std::memory_order_acquire);
+    const auto summary = entry.mHistogram.Summarize();
+    if (id == InvalidListenerId || summary.mCount == 0) {
+      continue;
+    }
+    std::fprintf(aOut,
+                 "%s{\"id\":%" PRIu32 ",\"count\":%" PRIu32
+                 ",\"p50_us\":%" PRIu32 ",\"p99_us\":%" PRIu32
+                 ",\"max_us\":%" PRIu32 "}",
+                 separator, id, summary.mCount, summary.mP50Us,
+                 summary.mP99Us, summary.mMaxUs);
+    separator = ",";
+  }
+  std::fprintf(aOut, "]}\n");
+}
+
+void Reset() {
+  for (auto &histogram : sQueueLatency) {
+    histogram.Reset();
+  }
+  for (auto &entry : sListenerLatency) {
+    entry.mHistogram.Reset();
+  }
+  sQueueHighWater.store(0, std::memory_order_relaxed);
+}
+#else
+void Record(Stage, EventId, ListenerId) {}
+
+void RecordQueueLatency(EventId, uint32_t) {}
+
+void RecordListenerLatency(ListenerId, uint32_t) {}
+
+void RecordQueueDepth(size_t) {}
+
+LatencySummary GetQueueLatency(EventId) { return LatencySummary{}; }
+
+LatencySummary GetListenerLatency(ListenerId) { return LatencySummary{}; }
+
+size_t GetQueueHighWater() { return 0; }
+
+size_t GetThreadRecords(TraceRecord *, size_t) { return 0; }
+
+size_t GetThreadRecords(size_t, TraceRecord *, size_t) { return 0; }
+
+size_t GetThreadIndex() { return MaxTracedThreads; }
+
+void WriteJson(std::FILE *aOut) {
+  std::fprintf(aOut, "{\"queue_high_water\":0,\"events\":[],"
+                     "\"listeners\":[]}\n");
+}
+
+void Reset() {}
+#endif
+}  // namespace Trace
+}  // namespace Events
@@ -0,0 +1,114 @@
+/**
+ * @file TopicTrie.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include "TopicTrie.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Events {
+namespace {
+// Length of the first level of aTopic
+size_t LevelLength(const char *aTopic) {
+  const auto end = std::strchr(aTopic, TopicTrie::Separator);
+  return end ? static_cast<size_t>(end - aTopic) : std::strlen(aTopic);
+}
+
+bool IsLevel(const char *aLevel, size_t aLength, char aWildcard) {
+  return aLength == 1 && aLevel[0] == aWildcard;
+}
+}  // namespace
+
+TopicTrie::TopicTrie() { Clear(); }
+
+bool TopicTrie::IsPattern(const char *aTopic) {
+  for (auto level = aTopic;; level += LevelLength(level) + 1) {
+    const auto length = LevelLength(level);
+    if (IsLevel(level, length, AnyLevel) || IsLevel(level, length, AnyLevels)) {
+      return true;
+    }
+    if (level[length] == '\0') {
+      return false;
+    }
+  }
+}
+
+void TopicTrie::Clear() {
+  mNodes.clear();
+  // Root node
+  mNodes.emplace_back();
+}
+
+void TopicTrie::Insert(const char *aPattern, size_t aValue) {
+  uint16_t node = 0;
+  for (auto level = aPattern;; level += LevelLength(level) + 1) {
+    const auto length = LevelLength(level);
+    if (IsLevel(level, length, AnyLevels)) {
+      // Anything after '#' could never be reached, so it ends the pattern
+      mNodes[node].mAnyLevelsValues.push_back(aValue);
+      return;
+    }
+    node = Child(node, level, length);
+    if (level[length] == '\0') {
+      mNodes[node].mValues.push_back(aValue);
+      return;
+    }
+  }
+}
+
+void TopicTrie::Match(const char *aTopic, std::vector<size_t> &aValues) const {
+  aValues.clear();
+  MatchFrom(0, aTopic, aValues);
+  std::sort(aValues.begin(), aValues.end());
+}
+
+uint16_t TopicTrie::Child(uint16_t aNode, const char *aLevel, size_t aLength) {
+  if (IsLevel(aLevel, aLength, AnyLevel)) {
+    if (mNodes[aNode].mAnyLevel == NoNode) {
+      mNodes[aNode].mAnyLevel = static_cast<uint16_t>(mNodes.size());
+      mNodes.emplace_back();
+    }
+    return mNodes[aNode].mAnyLevel;
+  }
+  for (const auto child : mNodes[aNode].mChildren) {
+    if (mNodes[child].mLevel.compare(0, std::string::npos, aLevel, aLength) ==
+        0) {
+      return child;
+    }
+  }
+  const auto child = static_cast<uint16_t>(mNodes.size());
+  mNodes.emplace_back();
+  mNodes.back().mLevel.assign(aLevel, aLength);
+  mNodes[aNode].mChildren.push_back(child);
+  return child;
+}
+
+void TopicTrie::MatchFrom(uint16_t aNode, const char *aTopic,
+                          std::vector<size_t> &aValues) const {
+  const auto &node = mNodes[aNode];
+  aValues.insert(aValues.end(), node.mAnyLevelsValues.begin(),
+                 node.mAnyLevelsValues.end());
+  if (*aTopic == '\0' && aNode != 0) {
+    aValues.insert(aValues.end(), node.mValues.begin(), node.mValues.end());
+    return;
+  }
+
+  const auto length = LevelLength(aTopic);
+  const auto rest = aTopic[length] == '\0' ? aTopic + length
+                                            : aTopic + length + 1;
+  for (const auto child : node.mChildren) {
+    if (mNodes[child].mLevel.compare(0, std::string::npos, aTopic, length) ==
+        0) {
+      MatchFrom(child, rest, aValues);
+      break;
+    }
+  }
+  if (node.mAnyLevel != NoNode) {
+    MatchFrom(node.mAnyLevel, rest, aValues);
+  }
+}
+}  // namespace Events
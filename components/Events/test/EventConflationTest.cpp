@@ -0,0 +1,112 @@
+/**
+ * @file EventConflationTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Event.hpp"
+#include "EventDispatcher.hpp"
+#include "EventPool.hpp"
+#include "EventQueue.hpp"
+
+namespace {
+constexpr size_t Producers = 4;
+constexpr uint32_t EventsPerProducer = 20000;
+// Small enough that the lane is full for much of the run
+constexpr size_t QueueCapacity = 2;
+constexpr uint32_t Sentinel = 0xFFFFFFFF;
+
+class FillerEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Test/Filler";
+
+  FillerEvent() : Events::Event(Events::GetEventId<FillerEvent>()) {}
+};
+
+class LatestEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Test/Latest";
+  static constexpr Events::OverflowPolicy Overflow =
+      Events::OverflowPolicy::Conflate;
+
+  explicit LatestEvent(uint32_t aValue)
+      : Events::Event(Events::GetEventId<LatestEvent>()), mValue(aValue) {}
+
+  uint32_t GetValue() const { return mValue; }
+
+ private:
+  uint32_t mValue;
+};
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char *aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+}  // namespace
+
+/**
+ * Races conflating producers against a full lane and checks that no Event is
+ * left in a conflation slot without a queue entry to deliver it.
+ */
+int main() {
+  Events::EventQueue queue(QueueCapacity);
+  Events::EventDispatcher dispatcher(queue);
+  std::atomic<uint32_t> latest{0};
+  dispatcher.Listen<FillerEvent>(
+      [](const FillerEvent &) { std::this_thread::yield(); });
+  dispatcher.Listen<LatestEvent>([&latest](const LatestEvent &aEvent) {
+    latest.store(aEvent.GetValue(), std::memory_order_relaxed);
+  });
+
+  std::atomic<bool> stopped{false};
+  std::thread consumer([&queue, &stopped] {
+    while (!stopped.load()) {
+      queue.WaitAndDrain(std::chrono::milliseconds(1));
+    }
+  });
+
+  std::atomic<uint32_t> dropped{0};
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < Producers; ++p) {
+    producers.emplace_back([&dispatcher, &dropped] {
+      for (uint32_t i = 0; i < EventsPerProducer; ++i) {
+        dispatcher.Dispatch<FillerEvent>();
+        if (dispatcher.Dispatch<LatestEvent>(i) ==
+            Events::DispatchStatus::Dropped) {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  stopped.store(true);
+  consumer.join();
+  while (queue.WaitAndDrain(std::chrono::milliseconds(0)) > 0) {
+  }
+  std::printf("conflated %u, dropped %u\n", queue.GetConflatedCount(),
+              dropped.load());
+
+  const auto stats = Events::EventPool<LatestEvent>::Instance().GetStats();
+  Check(stats.mInUse == 0, "an Event was left in a conflation slot");
+
+  Check(dispatcher.Dispatch<LatestEvent>(Sentinel) ==
+            Events::DispatchStatus::Queued,
+        "conflation slot still held an Event");
+  queue.WaitAndDrain(std::chrono::milliseconds(0));
+  Check(latest.load() == Sentinel, "the latest Event was not delivered");
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file EventPoolAllocTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "Event.hpp"
+#include "EventDispatcher.hpp"
+#include "EventPool.hpp"
+#include "EventQueue.hpp"
+
+namespace {
+std::atomic<bool> sCounting{false};
+std::atomic<size_t> sAllocations{0};
+}  // namespace
+
+namespace {
+void *CountedAlloc(size_t aSize) {
+  if (sCounting.load(std::memory_order_relaxed)) {
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void *memory = std::malloc(aSize ? aSize : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+// Counts every heap allocation made while sCounting is set. The whole set of
+// replaceable operators forwards to one malloc and free pair, so no delete
+// can be paired with an allocation function it does not match.
+void *operator new(size_t aSize) { return CountedAlloc(aSize); }
+void *operator new[](size_t aSize) { return CountedAlloc(aSize); }
+void operator delete(void *aMemory) noexcept { std::free(aMemory); }
+void operator delete[](void *aMemory) noexcept { std::free(aMemory); }
+void operator delete(void *aMemory, size_t) noexcept { std::free(aMemory); }
+void operator delete[](void *aMemory, size_t) noexcept { std::free(aMemory); }
+
+namespace {
+constexpr uint32_t WarmUpEvents = 64;
+constexpr uint32_t MeasuredEvents = 10000;
+
+class CountEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Test/Count";
+
+  explicit CountEvent(uint32_t aValue)
+      : Events::Event(Events::GetEventId<CountEvent>()), mValue(aValue) {}
+
+  uint32_t GetValue() const { return mValue; }
+
+ private:
+  uint32_t mValue;
+};
+
+class LatestEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Test/Latest";
+  static constexpr Events::OverflowPolicy Overflow =
+      Events::OverflowPolicy::Conflate;
+
+  explicit LatestEvent(uint32_t aValue)
+      : Events::Event(Events::GetEventId<LatestEvent>()), mValue(aValue) {}
+
+  uint32_t GetValue() const { return mValue; }
+
+ private:
+  uint32_t mValue;
+};
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char *aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+
+// Dispatches through aDispatch and drains the queue on this thread, returning
+// the number of allocations after the warm-up
+template <typename TDispatch>
+size_t CountAllocations(Events::EventQueue &aQueue, TDispatch aDispatch) {
+  for (uint32_t i = 0; i < WarmUpEvents; ++i) {
+    aDispatch(i);
+    aQueue.WaitAndDrain(std::chrono::milliseconds(0));
+  }
+  sAllocations.store(0);
+  sCounting.store(true);
+  for (uint32_t i = 0; i < MeasuredEvents; ++i) {
+    aDispatch(i);
+    aQueue.WaitAndDrain(std::chrono::milliseconds(0));
+  }
+  sCounting.store(false);
+  return sAllocations.load();
+}
+}  // namespace
+
+/**
+ * Proves that dispatching Events does not touch the heap once the pipeline is
+ * warmed up, for queued, conflated and inline delivery.
+ */
+int main() {
+  Events::EventQueue queue;
+  Events::EventDispatcher dispatcher(queue);
+  uint64_t sum = 0;
+  dispatcher.Listen<CountEvent>(
+      [&sum](const CountEvent &aEvent) { sum += aEvent.GetValue(); });
+  dispatcher.Listen<LatestEvent>(
+      [&sum](const LatestEvent &aEvent) { sum += aEvent.GetValue(); });
+  Events::ListenerOptions inlineOptions;
+  inlineOptions.mInline = true;
+  dispatcher.Listen<CountEvent>(
+      [&sum](const CountEvent &aEvent) { sum += aEvent.GetValue(); },
+      inlineOptions);
+
+  const auto queued = CountAllocations(queue, [&dispatcher](uint32_t aValue) {
+    dispatcher.Dispatch<CountEvent>(aValue);
+  });
+  std::printf("queued: %zu allocations in %u events\n", queued,
+              MeasuredEvents);
+  Check(queued == 0, "queued dispatch allocated");
+
+  const auto conflated =
+      CountAllocations(queue, [&dispatcher](uint32_t aValue) {
+        dispatcher.Dispatch<LatestEvent>(aValue);
+        dispatcher.Dispatch<LatestEvent>(aValue);
+      });
+  std::printf("conflated: %zu allocations in %u events\n", conflated,
+              MeasuredEvents);
+  Check(conflated == 0, "conflated dispatch allocated");
+
+  const auto inlined = CountAllocations(queue, [&dispatcher](uint32_t aValue) {
+    dispatcher.DispatchNow<CountEvent>(aValue);
+  });
+  std::printf("inline: %zu allocations in %u events\n", inlined,
+              MeasuredEvents);
+  Check(inlined == 0, "inline dispatch allocated");
+
+  const auto stats = Events::EventPool<CountEvent>::Instance().GetStats();
+  Check(stats.mExhausted == 0, "CountEvent pool fell back to the heap");
+  Check(stats.mInUse == 0, "CountEvent pool leaked Events");
+  Check(sum > 0, "no Event was delivered");
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
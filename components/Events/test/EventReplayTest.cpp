@@ -0,0 +1,124 @@
+/**
+ * @file EventReplayTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Event.hpp"
+#include "EventDispatcher.hpp"
+#include "EventPool.hpp"
+#include "EventQueue.hpp"
+#include "EventRecorder.hpp"
+#include "EventReplayer.hpp"
+
+namespace {
+constexpr uint32_t RecordedEvents = 20;
+// Room for every replayed Event, so the replay never blocks
+constexpr size_t QueueCapacity = 32;
+// One flash sector, the smallest range FlushToPartition erases
+constexpr size_t SectorSize = 4096;
+constexpr uint8_t ErasedByte = 0xFF;
+
+class ValueEvent : public Events::Event {
+ public:
+  static auto constexpr Id = "Test/Value";
+  static constexpr size_t PayloadSize = 4;
+
+  explicit ValueEvent(uint32_t aValue)
+      : Events::Event(Events::GetEventId<ValueEvent>()), mValue(aValue) {}
+
+  uint32_t GetValue() const { return mValue; }
+
+  size_t Serialize(uint8_t *aBuffer, size_t aSize) const override {
+    if (aSize < PayloadSize) {
+      return 0;
+    }
+    for (size_t i = 0; i < PayloadSize; ++i) {
+      aBuffer[i] = static_cast<uint8_t>(mValue >> (8 * i));
+    }
+    return PayloadSize;
+  }
+
+  static Events::EventPtr Deserialize(const uint8_t *aPayload, size_t aSize) {
+    if (aSize != PayloadSize) {
+      return nullptr;
+    }
+    uint32_t value = 0;
+    for (size_t i = 0; i < PayloadSize; ++i) {
+      value |= static_cast<uint32_t>(aPayload[i]) << (8 * i);
+    }
+    return Events::EventPool<ValueEvent>::Instance().Make(value);
+  }
+
+ private:
+  uint32_t mValue;
+};
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char *aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+}  // namespace
+
+/**
+ * Replays a recording the way FlushToPartition leaves it in flash, padded to
+ * the erased sector, and checks that the replay ends with the last record.
+ */
+int main() {
+  Events::EventRecorder recorder;
+  for (uint32_t i = 0; i < RecordedEvents; ++i) {
+    recorder.Record(ValueEvent(i));
+  }
+  std::vector<uint8_t> stream;
+  Check(recorder.Flush([&stream](const uint8_t *aData, size_t aSize) {
+    stream.insert(stream.end(), aData, aData + aSize);
+    return true;
+  }),
+        "the recording was not flushed");
+  const auto streamSize = stream.size();
+  Check(streamSize < SectorSize, "the recording does not fit a sector");
+  stream.resize(SectorSize, ErasedByte);
+
+  Events::EventQueue queue(QueueCapacity);
+  Events::EventDispatcher dispatcher(queue);
+  std::vector<uint32_t> replayed;
+  dispatcher.Listen<ValueEvent>([&replayed](const ValueEvent &aEvent) {
+    replayed.push_back(aEvent.GetValue());
+  });
+  Events::EventReplayer replayer(dispatcher);
+  replayer.AddDecoder<ValueEvent>();
+
+  Events::ReplayStats stats;
+  Check(replayer.Replay(stream.data(), stream.size(),
+                        Events::ReplaySpeed::AsFastAsPossible, stats),
+        "the padded recording was not replayed");
+  while (queue.WaitAndDrain(std::chrono::milliseconds(0)) > 0) {
+  }
+  std::printf("replayed %u of %u records from %zu stream bytes\n",
+              stats.mDispatched, stats.mRecords, streamSize);
+  Check(stats.mRecords == RecordedEvents, "the padding was read as records");
+  Check(stats.mUndecoded == 0, "a record was not decoded");
+  Check(stats.mDispatched == RecordedEvents, "a record was not dispatched");
+  Check(replayed.size() == RecordedEvents, "an Event was not delivered");
+  for (uint32_t i = 0; i < replayed.size(); ++i) {
+    Check(replayed[i] == i, "Events were replayed out of order");
+  }
+
+  // A stream cut short of its record bytes is malformed
+  Check(!replayer.Replay(stream.data(), streamSize - 1,
+                         Events::ReplaySpeed::AsFastAsPossible, stats),
+        "a truncated recording was replayed");
+  while (queue.WaitAndDrain(std::chrono::milliseconds(0)) > 0) {
+  }
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file EventTraceTest.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "EventTrace.hpp"
+
+namespace {
+constexpr uint32_t WrittenRecords = 200000;
+constexpr size_t MaxCopiedRecords = 64;
+
+int sFailures = 0;
+
+void Check(bool aCondition, const char *aWhat) {
+  if (!aCondition) {
+    std::printf("FAIL: %s\n", aWhat);
+    ++sFailures;
+  }
+}
+}  // namespace
+
+/**
+ * Copies a thread's trace ring from another thread while the owner keeps
+ * writing it and checks that no copied record is torn or out of order.
+ */
+int main() {
+#ifdef EVENTS_TRACING
+  std::atomic<size_t> ringIndex{Events::Trace::MaxTracedThreads};
+  std::atomic<bool> done{false};
+  // The listener ID numbers the records, the Event ID repeats its low byte
+  std::thread writer([&ringIndex, &done] {
+    for (uint32_t i = 0; i < WrittenRecords; ++i) {
+      Events::Trace::Record(Events::Trace::Stage::Dispatch,
+                            static_cast<Events::EventId>(i & 0xFF), i);
+      if (i == 0) {
+        ringIndex.store(Events::Trace::GetThreadIndex());
+      }
+    }
+    done.store(true);
+  });
+
+  uint32_t copies = 0;
+  uint32_t torn = 0;
+  uint32_t unordered = 0;
+  Events::Trace::TraceRecord records[MaxCopiedRecords];
+  while (!done.load()) {
+    const auto index = ringIndex.load();
+    if (index >= Events::Trace::MaxTracedThreads) {
+      continue;
+    }
+    const auto count =
+        Events::Trace::GetThreadRecords(index, records, MaxCopiedRecords);
+    ++copies;
+    for (size_t i = 0; i < count; ++i) {
+      if (records[i].mEventId != (records[i].mListenerId & 0xFF)) {
+        ++torn;
+      }
+      if (i > 0 && records[i].mListenerId <= records[i - 1].mListenerId) {
+        ++unordered;
+      }
+    }
+  }
+  writer.join();
+  std::printf("%u copies, %u torn, %u unordered records\n", copies, torn,
+              unordered);
+  Check(torn == 0, "a copied record was torn");
+  Check(unordered == 0, "copied records were out of order");
+
+  const auto index = ringIndex.load();
+  const auto count =
+      Events::Trace::GetThreadRecords(index, records, MaxCopiedRecords);
+  Check(count > 0, "the released ring lost its records");
+  Check(count > 0 && records[count - 1].mListenerId == WrittenRecords - 1,
+        "the newest record was not copied last");
+#else
+  std::printf("tracing disabled, nothing to check\n");
+#endif
+  return sFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
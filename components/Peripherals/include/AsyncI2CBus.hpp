@@ -0,0 +1,221 @@
+/**
+ * @file AsyncI2CBus.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ASYNC_I2C_BUS_H
+#define ASYNC_I2C_BUS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "I2CBus.hpp"
+#include "InplaceFunction.hpp"
+
+namespace I2C {
+/**
+ * @brief Called on the bus worker when a transaction completes
+ *
+ * @param aSuccess whether the transfer succeeded
+ */
+typedef Common::InplaceFunction<void(bool aSuccess), 4 * sizeof(void*)>
+    I2CCompletion;
+
+/**
+ * @brief Called on the bus worker when a transaction to a device failed
+ *
+ * @param aDevice Bus of the device
+ */
+typedef Common::InplaceFunction<void(I2CBus& aDevice), 4 * sizeof(void*)>
+    I2CFailureHandler;
+
+/**
+ * @brief Bus worker activity counters
+ *
+ */
+struct AsyncI2CStats {
+  uint32_t mSubmitted;
+  uint32_t mTransfers;
+  uint32_t mMerged;
+  uint32_t mFailed;
+  // Submissions refused because the command queue was full
+  uint32_t mRejected;
+  // Most commands waiting at once
+  uint32_t mMaxDepth;
+};
+
+/**
+ * @brief Runs I2C transactions on a dedicated worker thread
+ *
+ * Callers enqueue transactions without waiting for the bus, so a slow or
+ * stalled bus never blocks the submitting thread. The worker performs the
+ * transfers one at a time, in submission order, on the I2CBus of each target
+ * device. All devices on a port should be driven through the same
+ * AsyncI2CBus so the worker is the only thread touching the port.
+ *
+ * Write data is copied into a fixed command queue sized at construction, so
+ * submitting never allocates. A write to a device with auto-incrementing
+ * register addresses is merged into the queued write before it when it
+ * continues where that write ends.
+ */
+class AsyncI2CBus {
+ public:
+  static constexpr size_t DefaultQueueDepth = 16;
+  // Largest write, including the register address byte
+  static constexpr size_t MaxTransferSize = 32;
+
+  /**
+   * @brief Construct a new Async I2C Bus and start its worker
+   *
+   * @param aQueueDepth Maximum number of queued transactions
+   */
+  explicit AsyncI2CBus(size_t aQueueDepth = DefaultQueueDepth);
+
+  /**
+   * @brief Stops the worker. Queued transactions are completed with failure.
+   *
+   */
+  ~AsyncI2CBus();
+
+  AsyncI2CBus(const AsyncI2CBus&) = delete;
+  AsyncI2CBus& operator=(const AsyncI2CBus&) = delete;
+
+  /**
+   * @brief Queues a write
+   *
+   * @param aDevice Bus of the target device
+   * @param aData Data to be written, copied before returning
+   * @param aSize Number of bytes to write, at most MaxTransferSize
+   * @param aCompletion Called with the result of the write
+   * @param aAutoIncrement The first byte is a register address the device
+   * auto-increments, so writes continuing each other may be merged
+   * @return true the write was queued
+   * @return false the queue is full or the write is too large
+   */
+  bool Write(I2CBus& aDevice, const uint8_t* aData, size_t aSize,
+             I2CCompletion aCompletion = nullptr, bool aAutoIncrement = false);
+
+  /**
+   * @brief Queues a read
+   *
+   * @param aDevice Bus of the target device
+   * @param aBuffer Buffer to read the data in to, must stay valid until
+   * aCompletion is called
+   * @param aSize Number of bytes to read
+   * @param aCompletion Called with the result of the read
+   * @return true the read was queued
+   * @return false the queue is full
+   */
+  bool Read(I2CBus& aDevice, uint8_t* aBuffer, size_t aSize,
+            I2CCompletion aCompletion);
+
+  /**
+   * @brief Get the bus worker activity counters
+   *
+   * @return AsyncI2CStats
+   */
+  AsyncI2CStats GetStats();
+
+  /**
+   * @brief Whether the calling thread is the bus worker, i.e. a completion or
+   * failure handler is running
+   *
+   * @return true
+   * @return false
+   */
+  bool IsWorkerThread() const;
+
+  /**
+   * @brief Sets a handler called after every failed transaction, e.g. to
+   * resynchronize a driver whose queued writes report no result
+   *
+   * @param aHandler Handler run on the worker, or nullptr
+   */
+  void SetFailureHandler(I2CFailureHandler aHandler);
+
+ private:
+  struct Command {
+    I2CBus* mDevice = nullptr;
+    uint8_t* mReadBuffer = nullptr;
+    size_t mSize = 0;
+    bool mAutoIncrement = false;
+    uint8_t mData[MaxTransferSize];
+    I2CCompletion mCompletion;
+  };
+
+  bool Submit(Command& aCommand);
+  bool TryMerge(const Command& aCommand);
+  void ThreadLoop();
+
+  // Ring of queued commands, guarded by mMutex
+  std::vector<Command> mCommands;
+  size_t mHead = 0;
+  size_t mCount = 0;
+  AsyncI2CStats mStats{};
+  I2CFailureHandler mFailureHandler;
+  bool mStopped = false;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::thread mThread;
+};
+
+/**
+ * @brief I2CBus of a device driven through an AsyncI2CBus
+ *
+ * Lets existing drivers written against I2CBus use the bus worker. Writes are
+ * queued and return once copied, Reads wait for the worker.
+ */
+class AsyncI2CDevice : public I2CBus {
+ public:
+  /**
+   * @brief Construct a new Async I2C Device
+   *
+   * @param aBus Worker running the transactions
+   * @param aDevice Bus of the device
+   * @param aAutoIncrement The device auto-increments register addresses
+   */
+  AsyncI2CDevice(AsyncI2CBus& aBus, I2CBus& aDevice,
+                 bool aAutoIncrement = false);
+
+  using I2CBus::Read;
+  using I2CBus::Write;
+
+  /**
+   * @brief Queues a write without waiting for the bus
+   *
+   * @param aData Data to be written, copied before returning
+   * @param aSize Number of bytes to write
+   * @return true the write was queued
+   * @return false the queue is full or the write is too large
+   */
+  bool Write(const uint8_t* aData, size_t aSize) final;
+
+  /**
+   * @brief Reads through the worker and waits for the result
+   *
+   * Fails without reading when called from a completion or failure handler,
+   * the worker would wait for itself.
+   *
+   * @param aBuffer Buffer to read the data in to
+   * @param aSize Number of bytes to read
+   * @return true success
+   * @return false error, or called on the bus worker
+   */
+  bool Read(uint8_t* aBuffer, size_t aSize) final;
+
+ private:
+  AsyncI2CBus& mBus;
+  I2CBus& mDevice;
+  const bool mAutoIncrement;
+};
+}  // namespace I2C
+
+#endif  // ASYNC_I2C_BUS_H
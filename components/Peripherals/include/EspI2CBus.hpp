@@ -14,37 +14,44 @@
 #include "driver/i2c.h"
 
 namespace I2C {
+/**
+ * @brief Handle to one device on a port owned by EspI2CBusManager
+ *
+ * Handles are obtained from EspI2CBusManager::GetDevice and hold no driver
+ * state, so any number of devices can share a port.
+ */
 class EspI2CBus : public I2CBus {
-  static auto constexpr I2C_MASTER_TIMEOUT = 1000 / portTICK_PERIOD_MS;
-
  public:
-  EspI2CBus(const i2c_config_t& aConf, uint8_t aDeviceAddress,
-            i2c_port_t aPortNum);
-  ~EspI2CBus();
+  EspI2CBus(i2c_port_t aPortNum, uint8_t aDeviceAddress);
+  ~EspI2CBus() = default;
+
+  using I2CBus::Read;
+  using I2CBus::Write;
 
   /**
    * @brief Master write a stream of data over the I2C bus
    *
-   * @param aData Vector containing data to be written
+   * @param aData Data to be written, not retained after the call
+   * @param aSize Number of bytes to write
    * @return true success
    * @return false error
    */
-  bool Write(const std::vector<uint8_t>& aData) final;
+  bool Write(const uint8_t* aData, size_t aSize) final;
 
   /**
    * @brief Master read a stream of data into a buffer from the I2C bus
    *
-   * @param aNum Number of bytes to read
-   * @param aBuf Vector buffer to read the data in to
+   * @param aBuffer Buffer to read the data in to
+   * @param aSize Number of bytes to read, at most the size of aBuffer
    * @return true success
    * @return false error
    */
-  bool Read(std::vector<uint8_t>& aBuf, size_t aNum) final;
+  bool Read(uint8_t* aBuffer, size_t aSize) final;
 
  private:
-  const i2c_port_t mPortNum;
-  const uint8_t mDeviceAddress;
+  i2c_port_t mPortNum;
+  uint8_t mDeviceAddress;
 };
 }  // namespace I2C
 
-#endif
\ No newline at end of file
+#endif
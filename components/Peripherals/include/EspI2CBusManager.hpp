@@ -0,0 +1,148 @@
+/**
+ * @file EspI2CBusManager.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ESP_I2C_BUS_MANAGER_H
+#define ESP_I2C_BUS_MANAGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "EspI2CBus.hpp"
+#include "I2CStats.hpp"
+#include "driver/i2c.h"
+
+namespace I2C {
+/**
+ * @brief Port activity counters
+ *
+ */
+struct I2CPortStats {
+  I2CStats mTraffic;
+  // Attempts that had to wait for another one to finish
+  uint32_t mContended;
+  uint64_t mBusyUs;
+  uint64_t mWaitUs;
+  uint32_t mMaxWaitUs;
+  // Share of the time since Install the port spent transferring, 0 to 1
+  float mUtilization;
+};
+
+/**
+ * @brief Owns the ESP-IDF I2C master ports and arbitrates access to them
+ *
+ * Each port driver is installed once, however many devices share it. Devices
+ * are reached through EspI2CBus handles, which are cheap to copy and may be
+ * used from any thread. Transactions on a port run one at a time and are
+ * granted in arrival order, so a busy device cannot starve the others.
+ *
+ * A transaction the device NACKs or that times out is retried up to
+ * MaxAttempts times, backing off between attempts so a device busy with an
+ * internal operation gets time to finish. Other devices on the port may run
+ * during the backoff.
+ */
+class EspI2CBusManager {
+ public:
+  static auto constexpr I2C_MASTER_TIMEOUT = 1000 / portTICK_PERIOD_MS;
+  static constexpr uint32_t MaxAttempts = 3;
+  // Backoff before the first retry, doubled before each next one
+  static constexpr std::chrono::milliseconds RetryBackoff{1};
+  // Devices per port with their own counters, further devices are only
+  // counted in the port totals
+  static constexpr size_t MaxDevicesPerPort = 8;
+
+  /**
+   * @brief Returns the manager of every I2C port on the chip
+   *
+   * @return EspI2CBusManager&
+   */
+  static EspI2CBusManager& Instance();
+
+  EspI2CBusManager(const EspI2CBusManager&) = delete;
+  EspI2CBusManager& operator=(const EspI2CBusManager&) = delete;
+
+  /**
+   * @brief Configures a port and installs its master driver
+   *
+   * @param aPortNum Port to install
+   * @param aConf Pins and clock of the port
+   * @return true the port is ready, including when it was already installed
+   * @return false the port number is invalid or the driver failed to install
+   */
+  bool Install(i2c_port_t aPortNum, const i2c_config_t& aConf);
+
+  /**
+   * @brief Returns a handle to a device on an installed port
+   *
+   * @param aPortNum Port the device is wired to
+   * @param aDeviceAddress 7 bit address of the device
+   * @return EspI2CBus
+   */
+  EspI2CBus GetDevice(i2c_port_t aPortNum, uint8_t aDeviceAddress);
+
+  /**
+   * @brief Get the activity counters of a port
+   *
+   * @param aPortNum Port to query
+   * @return I2CPortStats
+   */
+  I2CPortStats GetStats(i2c_port_t aPortNum);
+
+  /**
+   * @brief Get the transfer counters of a device
+   *
+   * @param aPortNum Port the device is wired to
+   * @param aDeviceAddress 7 bit address of the device
+   * @return I2CStats all zero if no handle to the device was obtained from
+   * GetDevice
+   */
+  I2CStats GetDeviceStats(i2c_port_t aPortNum, uint8_t aDeviceAddress);
+
+ private:
+  friend class EspI2CBus;
+
+  struct Device {
+    uint8_t mAddress;
+    I2CStats mStats;
+  };
+
+  struct Port {
+    bool mInstalled = false;
+    // Ticket lock, transactions run in the order they took a ticket
+    uint32_t mNextTicket = 0;
+    uint32_t mServing = 0;
+    std::chrono::steady_clock::time_point mInstallTime;
+    I2CPortStats mStats{};
+    Device mDevices[MaxDevicesPerPort]{};
+    size_t mDeviceCount = 0;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+  };
+
+  EspI2CBusManager() = default;
+
+  bool Write(i2c_port_t aPortNum, uint8_t aDeviceAddress, const uint8_t* aData,
+             size_t aSize);
+  bool Read(i2c_port_t aPortNum, uint8_t aDeviceAddress, uint8_t* aBuffer,
+            size_t aSize);
+  template <typename TTransfer>
+  bool Transact(i2c_port_t aPortNum, uint8_t aDeviceAddress, size_t aSize,
+                TTransfer&& aTransfer);
+  template <typename TTransfer>
+  esp_err_t Attempt(Port& aPort, uint8_t aDeviceAddress,
+                    TTransfer& aTransfer);
+  static I2CStats* FindDevice(Port& aPort, uint8_t aDeviceAddress);
+
+  Port mPorts[I2C_NUM_MAX];
+};
+}  // namespace I2C
+
+#endif  // ESP_I2C_BUS_MANAGER_H
@@ -10,30 +10,57 @@
 #ifndef I2C_BUS_H
 #define I2C_BUS_H
 
+#include <cstddef>
 #include <cstdint>
-#include <vector>
 
 namespace I2C {
 class I2CBus {
  public:
+  virtual ~I2CBus() = default;
+
   /**
    * @brief Master write a stream of data over the I2C bus
    *
-   * @param aData Vector containing data to be written
+   * @param aData Data to be written, not retained after the call
+   * @param aSize Number of bytes to write
    * @return true success
    * @return false error
    */
-  virtual bool Write(const std::vector<uint8_t>& aData) = 0;
+  virtual bool Write(const uint8_t* aData, size_t aSize) = 0;
 
   /**
    * @brief Master read a stream of data into a buffer from the I2C bus
    *
-   * @param aNum Number of bytes to read
-   * @param aBuf Vector buffer to read the data in to
+   * @param aBuffer Buffer to read the data in to
+   * @param aSize Number of bytes to read, at most the size of aBuffer
+   * @return true success
+   * @return false error
+   */
+  virtual bool Read(uint8_t* aBuffer, size_t aSize) = 0;
+
+  /**
+   * @brief Master write a fixed-size buffer over the I2C bus
+   *
+   * @param aData Data to be written
+   * @return true success
+   * @return false error
+   */
+  template <size_t TSize>
+  bool Write(const uint8_t (&aData)[TSize]) {
+    return Write(aData, TSize);
+  }
+
+  /**
+   * @brief Master read from the I2C bus until a fixed-size buffer is full
+   *
+   * @param aBuffer Buffer to read the data in to
    * @return true success
    * @return false error
    */
-  virtual bool Read(std::vector<uint8_t>& aBuf, size_t aNum) = 0;
+  template <size_t TSize>
+  bool Read(uint8_t (&aBuffer)[TSize]) {
+    return Read(aBuffer, TSize);
+  }
 };
 }  // namespace I2C
 
@@ -0,0 +1,91 @@
+/**
+ * @file I2CStats.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef I2C_STATS_H
+#define I2C_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace I2C {
+/**
+ * @brief Why a transfer failed
+ *
+ */
+enum class I2CError : uint8_t {
+  // The device did not acknowledge its address or a byte
+  Nack,
+  // The bus was held, e.g. by clock stretching or a stuck SDA line
+  Timeout,
+  // The driver is not installed or the port is busy
+  InvalidState,
+  InvalidArgument,
+  Other,
+  Count,
+};
+
+/**
+ * @brief Transfer counters of a bus or a device
+ *
+ */
+struct I2CStats {
+  static constexpr size_t ErrorCount = static_cast<size_t>(I2CError::Count);
+  static constexpr size_t LatencyBuckets = 8;
+  // Upper bound of the first latency bucket, each next bucket doubles it
+  static constexpr uint32_t FirstLatencyBucketUs = 128;
+
+  uint32_t mTransactions;
+  uint32_t mBytes;
+  // Transactions that still failed after every retry
+  uint32_t mFailed;
+  uint32_t mRetries;
+  // Failed attempts by I2CError
+  uint32_t mErrors[ErrorCount];
+  // Attempts by duration. Bucket i counts durations below
+  // FirstLatencyBucketUs << i, the last bucket counts everything longer.
+  uint32_t mLatency[LatencyBuckets];
+
+  /**
+   * @brief Counts one transfer attempt
+   *
+   * @param aDurationUs How long the attempt took
+   * @param aSuccess Whether the attempt succeeded
+   * @param aError Why the attempt failed, ignored on success
+   */
+  void RecordAttempt(uint32_t aDurationUs, bool aSuccess, I2CError aError) {
+    size_t bucket = 0;
+    while (bucket + 1 < LatencyBuckets &&
+           aDurationUs >= FirstLatencyBucketUs << bucket) {
+      ++bucket;
+    }
+    ++mLatency[bucket];
+    if (!aSuccess) {
+      ++mErrors[static_cast<size_t>(aError)];
+    }
+  }
+
+  /**
+   * @brief Counts one transaction after its last attempt
+   *
+   * @param aSize Bytes transferred
+   * @param aAttempts Attempts it took, including the first
+   * @param aSuccess Whether the last attempt succeeded
+   */
+  void RecordTransaction(size_t aSize, uint32_t aAttempts, bool aSuccess) {
+    ++mTransactions;
+    mBytes += aSize;
+    mRetries += aAttempts - 1;
+    if (!aSuccess) {
+      ++mFailed;
+    }
+  }
+};
+}  // namespace I2C
+
+#endif  // I2C_STATS_H
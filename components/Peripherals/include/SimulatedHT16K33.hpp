@@ -0,0 +1,98 @@
+/**
+ * @file SimulatedHT16K33.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SIMULATED_HT16K33_H
+#define SIMULATED_HT16K33_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SimulatedI2CBus.hpp"
+
+namespace I2C {
+/**
+ * @brief Emulates the I2C interface of an HT16K33 LED driver
+ *
+ * Models the system setup, display setup and dimming commands, the 16 byte
+ * display RAM and the 6 byte key RAM. A write starting with a RAM address
+ * stores the following bytes from that address on, and reads return RAM from
+ * the last address written, both auto-incrementing and wrapping within the
+ * RAM.
+ */
+class SimulatedHT16K33 : public SimulatedI2CDevice {
+ public:
+  static constexpr size_t DisplayRamSize = 16;
+  static constexpr size_t KeyRamSize = 6;
+
+  enum class Blink : uint8_t {
+    Off = 0,
+    Blink2Hz = 1,
+    Blink1Hz = 2,
+    BlinkHalfHz = 3,
+  };
+
+  bool OnWrite(const uint8_t* aData, size_t aSize) final;
+  bool OnRead(uint8_t* aBuffer, size_t aSize) final;
+
+  bool IsOscillatorOn() const { return mOscillatorOn; }
+  bool IsDisplayOn() const { return mDisplayOn; }
+  Blink GetBlink() const { return mBlink; }
+
+  /**
+   * @brief Get the dimming level
+   *
+   * @return uint8_t duty cycle from 0x0 (1/16) to 0xF (16/16)
+   */
+  uint8_t GetBrightness() const { return mBrightness; }
+
+  /**
+   * @brief Get the contents of the display RAM
+   *
+   * @return const uint8_t* DisplayRamSize bytes, two per COM line holding
+   * ROW0 to ROW7 then ROW8 to ROW15
+   */
+  const uint8_t* GetDisplayRam() const { return mDisplayRam; }
+
+  /**
+   * @brief Sets the key scan result returned by key RAM reads
+   *
+   * @param aKeys KeyRamSize bytes
+   */
+  void SetKeyRam(const uint8_t* aKeys);
+
+  /**
+   * @brief Number of commands the chip would not recognise
+   *
+   * @return uint32_t
+   */
+  uint32_t GetInvalidCommands() const { return mInvalidCommands; }
+
+ private:
+  enum Command : uint8_t {
+    DisplayAddress = 0x00,
+    SystemSetup = 0x20,
+    KeyAddress = 0x40,
+    DisplaySetup = 0x80,
+    Dimming = 0xE0,
+  };
+
+  bool mOscillatorOn = false;
+  bool mDisplayOn = false;
+  Blink mBlink = Blink::Off;
+  // Dimming is full duty at power on
+  uint8_t mBrightness = 0xF;
+  bool mKeyPointer = false;
+  uint8_t mPointer = 0;
+  uint8_t mDisplayRam[DisplayRamSize]{};
+  uint8_t mKeyRam[KeyRamSize]{};
+  uint32_t mInvalidCommands = 0;
+};
+}  // namespace I2C
+
+#endif  // SIMULATED_HT16K33_H
@@ -0,0 +1,139 @@
+/**
+ * @file SimulatedI2CBus.hpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SIMULATED_I2C_BUS_H
+#define SIMULATED_I2C_BUS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "I2CBus.hpp"
+
+namespace I2C {
+/**
+ * @brief Device emulated behind a SimulatedI2CBus
+ *
+ */
+class SimulatedI2CDevice {
+ public:
+  virtual ~SimulatedI2CDevice() = default;
+
+  /**
+   * @brief Handles a master write addressed to the device
+   *
+   * @param aData Bytes after the address byte
+   * @param aSize Number of bytes
+   * @return true the device acknowledged every byte
+   * @return false the device NACKed
+   */
+  virtual bool OnWrite(const uint8_t* aData, size_t aSize) = 0;
+
+  /**
+   * @brief Handles a master read addressed to the device
+   *
+   * @param aBuffer Receives the bytes sent by the device
+   * @param aSize Number of bytes
+   * @return true the device acknowledged its address
+   * @return false the device NACKed
+   */
+  virtual bool OnRead(uint8_t* aBuffer, size_t aSize) = 0;
+};
+
+/**
+ * @brief Simulated bus activity counters
+ *
+ */
+struct SimulatedI2CStats {
+  uint32_t mTransactions;
+  // Bytes on the wire, including address bytes
+  uint32_t mBytes;
+  // Clock periods on the wire, including START and STOP
+  uint64_t mBits;
+  std::chrono::nanoseconds mBusTime;
+};
+
+/**
+ * @brief Host-side I2CBus driving an emulated device
+ *
+ * No time passes on the host. Instead each transaction charges the time it
+ * would take on a real bus: START, then the address byte and every data byte
+ * as 8 bits plus an ACK, then STOP, each costing one clock period. Clock
+ * stretching and bus arbitration are not modelled.
+ */
+class SimulatedI2CBus : public I2CBus {
+ public:
+  // Clock configured for the display bus in app_clock_display
+  static constexpr uint32_t DefaultClockHz = 400000;
+  static constexpr uint32_t BitsPerByte = 9;
+
+  /**
+   * @brief Construct a new Simulated I2C Bus
+   *
+   * @param aDevice Device answering on the bus
+   * @param aClockHz SCL frequency the time model is based on
+   */
+  explicit SimulatedI2CBus(SimulatedI2CDevice& aDevice,
+                           uint32_t aClockHz = DefaultClockHz);
+
+  using I2CBus::Read;
+  using I2CBus::Write;
+
+  /**
+   * @brief Master write a stream of data to the emulated device
+   *
+   * @param aData Data to be written, not retained after the call
+   * @param aSize Number of bytes to write
+   * @return true success
+   * @return false error
+   */
+  bool Write(const uint8_t* aData, size_t aSize) final;
+
+  /**
+   * @brief Master read a stream of data from the emulated device
+   *
+   * @param aBuffer Buffer to read the data in to
+   * @param aSize Number of bytes to read, at most the size of aBuffer
+   * @return true success
+   * @return false error
+   */
+  bool Read(uint8_t* aBuffer, size_t aSize) final;
+
+  /**
+   * @brief Get the simulated bus activity counters
+   *
+   * @return SimulatedI2CStats
+   */
+  SimulatedI2CStats GetStats() const;
+
+  /**
+   * @brief Resets the counters, e.g. between measured frames
+   *
+   */
+  void ResetStats();
+
+  /**
+   * @brief Makes the next writes fail as if the device NACKed its address,
+   * without reaching the device, e.g. to test error recovery
+   *
+   * @param aCount Number of writes to fail
+   */
+  void FailNextWrites(uint32_t aCount);
+
+ private:
+  void Charge(size_t aSize);
+
+  SimulatedI2CDevice& mDevice;
+  const uint32_t mClockHz;
+  SimulatedI2CStats mStats{};
+  uint32_t mFailWrites = 0;
+};
+}  // namespace I2C
+
+#endif  // SIMULATED_I2C_BUS_H
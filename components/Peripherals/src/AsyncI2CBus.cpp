@@ -0,0 +1,200 @@
+/**
+ * @file AsyncI2CBus.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "AsyncI2CBus.hpp"
+
+#include <algorithm>
+
+#include "ScopedThreadConfig.hpp"
+
+namespace I2C {
+AsyncI2CBus::AsyncI2CBus(const size_t aQueueDepth)
+    : mCommands(std::max<size_t>(aQueueDepth, 1)) {
+  Common::ScopedThreadConfig config("i2c_bus");
+  mThread = std::thread(&AsyncI2CBus::ThreadLoop, this);
+}
+
+AsyncI2CBus::~AsyncI2CBus() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopped = true;
+  }
+  mCondition.notify_one();
+  mThread.join();
+
+  for (; mCount > 0; --mCount) {
+    auto& command = mCommands[mHead];
+    if (command.mCompletion) {
+      command.mCompletion(false);
+    }
+    mHead = (mHead + 1) % mCommands.size();
+  }
+}
+
+bool AsyncI2CBus::Write(I2CBus& aDevice, const uint8_t* aData,
+                        const size_t aSize, I2CCompletion aCompletion,
+                        const bool aAutoIncrement) {
+  if (aSize == 0 || aSize > MaxTransferSize) {
+    return false;
+  }
+  Command command;
+  command.mDevice = &aDevice;
+  command.mSize = aSize;
+  command.mAutoIncrement = aAutoIncrement;
+  std::copy(aData, aData + aSize, command.mData);
+  command.mCompletion = std::move(aCompletion);
+  return Submit(command);
+}
+
+bool AsyncI2CBus::Read(I2CBus& aDevice, uint8_t* aBuffer, const size_t aSize,
+                       I2CCompletion aCompletion) {
+  if (aSize == 0) {
+    return false;
+  }
+  Command command;
+  command.mDevice = &aDevice;
+  command.mReadBuffer = aBuffer;
+  command.mSize = aSize;
+  command.mCompletion = std::move(aCompletion);
+  return Submit(command);
+}
+
+AsyncI2CStats AsyncI2CBus::GetStats() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+bool AsyncI2CBus::IsWorkerThread() const {
+  return std::this_thread::get_id() == mThread.get_id();
+}
+
+void AsyncI2CBus::SetFailureHandler(I2CFailureHandler aHandler) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFailureHandler = std::move(aHandler);
+}
+
+bool AsyncI2CBus::Submit(Command& aCommand) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStopped) {
+      return false;
+    }
+    ++mStats.mSubmitted;
+    if (TryMerge(aCommand)) {
+      ++mStats.mMerged;
+      return true;
+    }
+    if (mCount == mCommands.size()) {
+      ++mStats.mRejected;
+      return false;
+    }
+    mCommands[(mHead + mCount) % mCommands.size()] = std::move(aCommand);
+    ++mCount;
+    mStats.mMaxDepth =
+        std::max(mStats.mMaxDepth, static_cast<uint32_t>(mCount));
+  }
+  mCondition.notify_one();
+  return true;
+}
+
+bool AsyncI2CBus::TryMerge(const Command& aCommand) {
+  if (mCount == 0 || aCommand.mReadBuffer || !aCommand.mAutoIncrement ||
+      aCommand.mSize < 2) {
+    return false;
+  }
+  // Only commands the worker has not taken yet are in the ring
+  auto& last = mCommands[(mHead + mCount - 1) % mCommands.size()];
+  const auto payloadSize = aCommand.mSize - 1;
+  if (last.mDevice != aCommand.mDevice || last.mReadBuffer ||
+      !last.mAutoIncrement || last.mSize < 2 || last.mCompletion ||
+      last.mSize + payloadSize > MaxTransferSize ||
+      last.mData[0] + last.mSize - 1 != aCommand.mData[0]) {
+    return false;
+  }
+  // Append the data after the register address and take over the
+  // completion, the previous write had none
+  std::copy(aCommand.mData + 1, aCommand.mData + aCommand.mSize,
+            last.mData + last.mSize);
+  last.mSize += payloadSize;
+  last.mCompletion = aCommand.mCompletion;
+  return true;
+}
+
+void AsyncI2CBus::ThreadLoop() {
+  while (true) {
+    Command command;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this] { return mStopped || mCount > 0; });
+      if (mStopped) {
+        return;
+      }
+      command = std::move(mCommands[mHead]);
+      mCommands[mHead].mCompletion = nullptr;
+      mHead = (mHead + 1) % mCommands.size();
+      --mCount;
+    }
+
+    const auto success =
+        command.mReadBuffer
+            ? command.mDevice->Read(command.mReadBuffer, command.mSize)
+            : command.mDevice->Write(command.mData, command.mSize);
+    I2CFailureHandler failureHandler;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      ++mStats.mTransfers;
+      if (!success) {
+        ++mStats.mFailed;
+        failureHandler = mFailureHandler;
+      }
+    }
+    if (failureHandler) {
+      failureHandler(*command.mDevice);
+    }
+    if (command.mCompletion) {
+      command.mCompletion(success);
+    }
+  }
+}
+
+AsyncI2CDevice::AsyncI2CDevice(AsyncI2CBus& aBus, I2CBus& aDevice,
+                               const bool aAutoIncrement)
+    : mBus(aBus), mDevice(aDevice), mAutoIncrement(aAutoIncrement) {}
+
+bool AsyncI2CDevice::Write(const uint8_t* aData, const size_t aSize) {
+  return mBus.Write(mDevice, aData, aSize, nullptr, mAutoIncrement);
+}
+
+bool AsyncI2CDevice::Read(uint8_t* aBuffer, const size_t aSize) {
+  if (mBus.IsWorkerThread()) {
+    // The read would queue behind the handler that is waiting for it
+    return false;
+  }
+  struct Result {
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mDone = false;
+    bool mSuccess = false;
+  } result;
+  const auto queued =
+      mBus.Read(mDevice, aBuffer, aSize, [&result](bool aSuccess) {
+        // Notify under the lock, result is gone once the waiter sees mDone
+        std::lock_guard<std::mutex> lock(result.mMutex);
+        result.mDone = true;
+        result.mSuccess = aSuccess;
+        result.mCondition.notify_one();
+      });
+  if (!queued) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock(result.mMutex);
+  result.mCondition.wait(lock, [&result] { return result.mDone; });
+  return result.mSuccess;
+}
+}  // namespace I2C
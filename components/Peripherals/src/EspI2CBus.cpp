@@ -9,29 +9,24 @@
 
 #include "EspI2CBus.hpp"
 
-namespace I2C {
-EspI2CBus::EspI2CBus(const i2c_config_t& aConf, const uint8_t aDeviceAddress,
-                     const i2c_port_t aPortNum)
-    : mPortNum(aPortNum), mDeviceAddress(aDeviceAddress) {
-  i2c_param_config(aPortNum, &aConf);
-  i2c_driver_install(aPortNum, aConf.mode, 0, 0, 0);
-}
+#include "EspI2CBusManager.hpp"
 
-EspI2CBus::~EspI2CBus() { i2c_driver_delete(mPortNum); }
+namespace I2C {
+EspI2CBus::EspI2CBus(const i2c_port_t aPortNum, const uint8_t aDeviceAddress)
+    : mPortNum(aPortNum), mDeviceAddress(aDeviceAddress) {}
 
-bool EspI2CBus::Write(const std::vector<uint8_t>& aData) {
-  if (aData.empty()) return false;
+bool EspI2CBus::Write(const uint8_t* aData, size_t aSize) {
+  if (aSize == 0) return false;
 
-  return i2c_master_write_to_device(mPortNum, mDeviceAddress, aData.data(),
-                                    aData.size(), I2C_MASTER_TIMEOUT) == ESP_OK;
+  return EspI2CBusManager::Instance().Write(mPortNum, mDeviceAddress, aData,
+                                            aSize);
 }
 
-bool EspI2CBus::Read(std::vector<uint8_t>& aBuf, size_t aNum) {
-  aBuf.clear();
-  aBuf.reserve(aNum);
+bool EspI2CBus::Read(uint8_t* aBuffer, size_t aSize) {
+  if (aSize == 0) return false;
 
-  return i2c_master_read_from_device(mPortNum, mDeviceAddress, aBuf.data(),
-                                     aNum, I2C_MASTER_TIMEOUT);
+  return EspI2CBusManager::Instance().Read(mPortNum, mDeviceAddress, aBuffer,
+                                           aSize);
 }
 
 }  // namespace I2C
\ No newline at end of file
@@ -0,0 +1,210 @@
+/**
+ * @file EspI2CBusManager.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "EspI2CBusManager.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace I2C {
+namespace {
+uint64_t MicrosecondsBetween(std::chrono::steady_clock::time_point aStart,
+                             std::chrono::steady_clock::time_point aEnd) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(aEnd - aStart)
+      .count();
+}
+
+I2CError ToI2CError(const esp_err_t aError) {
+  switch (aError) {
+    case ESP_FAIL:
+      // The driver reports a missing ACK as a generic failure
+      return I2CError::Nack;
+    case ESP_ERR_TIMEOUT:
+      return I2CError::Timeout;
+    case ESP_ERR_INVALID_STATE:
+      return I2CError::InvalidState;
+    case ESP_ERR_INVALID_ARG:
+      return I2CError::InvalidArgument;
+    default:
+      return I2CError::Other;
+  }
+}
+
+// Only failures a device or the bus may recover from are worth a retry
+bool IsRetryable(const esp_err_t aError) {
+  return aError == ESP_FAIL || aError == ESP_ERR_TIMEOUT;
+}
+}  // namespace
+
+EspI2CBusManager& EspI2CBusManager::Instance() {
+  static EspI2CBusManager manager;
+  return manager;
+}
+
+bool EspI2CBusManager::Install(const i2c_port_t aPortNum,
+                               const i2c_config_t& aConf) {
+  if (aPortNum < 0 || aPortNum >= I2C_NUM_MAX) {
+    return false;
+  }
+  auto& port = mPorts[aPortNum];
+  std::lock_guard<std::mutex> lock(port.mMutex);
+  if (port.mInstalled) {
+    return true;
+  }
+  if (i2c_param_config(aPortNum, &aConf) != ESP_OK ||
+      i2c_driver_install(aPortNum, aConf.mode, 0, 0, 0) != ESP_OK) {
+    return false;
+  }
+  port.mInstalled = true;
+  port.mInstallTime = std::chrono::steady_clock::now();
+  return true;
+}
+
+EspI2CBus EspI2CBusManager::GetDevice(const i2c_port_t aPortNum,
+                                      const uint8_t aDeviceAddress) {
+  if (aPortNum >= 0 && aPortNum < I2C_NUM_MAX) {
+    auto& port = mPorts[aPortNum];
+    std::lock_guard<std::mutex> lock(port.mMutex);
+    if (!FindDevice(port, aDeviceAddress) &&
+        port.mDeviceCount < MaxDevicesPerPort) {
+      port.mDevices[port.mDeviceCount++].mAddress = aDeviceAddress;
+    }
+  }
+  return EspI2CBus(aPortNum, aDeviceAddress);
+}
+
+I2CPortStats EspI2CBusManager::GetStats(const i2c_port_t aPortNum) {
+  if (aPortNum < 0 || aPortNum >= I2C_NUM_MAX) {
+    return I2CPortStats{};
+  }
+  auto& port = mPorts[aPortNum];
+  std::lock_guard<std::mutex> lock(port.mMutex);
+  auto stats = port.mStats;
+  const auto elapsedUs =
+      MicrosecondsBetween(port.mInstallTime, std::chrono::steady_clock::now());
+  stats.mUtilization =
+      port.mInstalled && elapsedUs > 0
+          ? static_cast<float>(stats.mBusyUs) / static_cast<float>(elapsedUs)
+          : 0.0f;
+  return stats;
+}
+
+I2CStats EspI2CBusManager::GetDeviceStats(const i2c_port_t aPortNum,
+                                          const uint8_t aDeviceAddress) {
+  if (aPortNum < 0 || aPortNum >= I2C_NUM_MAX) {
+    return I2CStats{};
+  }
+  auto& port = mPorts[aPortNum];
+  std::lock_guard<std::mutex> lock(port.mMutex);
+  const auto device = FindDevice(port, aDeviceAddress);
+  return device ? *device : I2CStats{};
+}
+
+bool EspI2CBusManager::Write(const i2c_port_t aPortNum,
+                             const uint8_t aDeviceAddress,
+                             const uint8_t* aData, const size_t aSize) {
+  return Transact(aPortNum, aDeviceAddress, aSize, [=] {
+    return i2c_master_write_to_device(aPortNum, aDeviceAddress, aData, aSize,
+                                      I2C_MASTER_TIMEOUT);
+  });
+}
+
+bool EspI2CBusManager::Read(const i2c_port_t aPortNum,
+                            const uint8_t aDeviceAddress, uint8_t* aBuffer,
+                            const size_t aSize) {
+  return Transact(aPortNum, aDeviceAddress, aSize, [=] {
+    return i2c_master_read_from_device(aPortNum, aDeviceAddress, aBuffer,
+                                       aSize, I2C_MASTER_TIMEOUT);
+  });
+}
+
+template <typename TTransfer>
+bool EspI2CBusManager::Transact(const i2c_port_t aPortNum,
+                                const uint8_t aDeviceAddress,
+                                const size_t aSize, TTransfer&& aTransfer) {
+  if (aPortNum < 0 || aPortNum >= I2C_NUM_MAX) {
+    return false;
+  }
+  auto& port = mPorts[aPortNum];
+  {
+    std::lock_guard<std::mutex> lock(port.mMutex);
+    if (!port.mInstalled) {
+      return false;
+    }
+  }
+
+  uint32_t attempts = 0;
+  auto backoff = RetryBackoff;
+  esp_err_t result;
+  while (true) {
+    ++attempts;
+    result = Attempt(port, aDeviceAddress, aTransfer);
+    if (result == ESP_OK || attempts == MaxAttempts || !IsRetryable(result)) {
+      break;
+    }
+    // Back off without holding the port so other devices can use it
+    std::this_thread::sleep_for(backoff);
+    backoff *= 2;
+  }
+
+  const auto success = result == ESP_OK;
+  std::lock_guard<std::mutex> lock(port.mMutex);
+  port.mStats.mTraffic.RecordTransaction(aSize, attempts, success);
+  if (const auto device = FindDevice(port, aDeviceAddress)) {
+    device->RecordTransaction(aSize, attempts, success);
+  }
+  return success;
+}
+
+template <typename TTransfer>
+esp_err_t EspI2CBusManager::Attempt(Port& aPort, const uint8_t aDeviceAddress,
+                                    TTransfer& aTransfer) {
+  const auto arrival = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(aPort.mMutex);
+  const auto ticket = aPort.mNextTicket++;
+  if (aPort.mServing != ticket) {
+    ++aPort.mStats.mContended;
+    aPort.mCondition.wait(
+        lock, [&aPort, ticket] { return aPort.mServing == ticket; });
+  }
+  lock.unlock();
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto result = aTransfer();
+  const auto end = std::chrono::steady_clock::now();
+
+  lock.lock();
+  const auto waitUs = MicrosecondsBetween(arrival, start);
+  const auto durationUs = MicrosecondsBetween(start, end);
+  const auto error = ToI2CError(result);
+  aPort.mStats.mTraffic.RecordAttempt(durationUs, result == ESP_OK, error);
+  if (const auto device = FindDevice(aPort, aDeviceAddress)) {
+    device->RecordAttempt(durationUs, result == ESP_OK, error);
+  }
+  aPort.mStats.mBusyUs += durationUs;
+  aPort.mStats.mWaitUs += waitUs;
+  aPort.mStats.mMaxWaitUs =
+      std::max(aPort.mStats.mMaxWaitUs, static_cast<uint32_t>(waitUs));
+  ++aPort.mServing;
+  lock.unlock();
+  // Every waiter checks whether its ticket is up
+  aPort.mCondition.notify_all();
+  return result;
+}
+
+I2CStats* EspI2CBusManager::FindDevice(Port& aPort,
+                                       const uint8_t aDeviceAddress) {
+  for (size_t i = 0; i < aPort.mDeviceCount; ++i) {
+    if (aPort.mDevices[i].mAddress == aDeviceAddress) {
+      return &aPort.mDevices[i].mStats;
+    }
+  }
+  return nullptr;
+}
+}  // namespace I2C
@@ -0,0 +1,65 @@
+/**
+ * @file SimulatedHT16K33.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "SimulatedHT16K33.hpp"
+
+#include <algorithm>
+
+namespace I2C {
+bool SimulatedHT16K33::OnWrite(const uint8_t* aData, const size_t aSize) {
+  const auto command = aData[0];
+  switch (command & 0xF0) {
+    case Command::DisplayAddress:
+      // Display data, auto-incrementing through the RAM
+      mKeyPointer = false;
+      mPointer = command & 0x0F;
+      for (size_t i = 1; i < aSize; ++i) {
+        mDisplayRam[mPointer] = aData[i];
+        mPointer = (mPointer + 1) % DisplayRamSize;
+      }
+      return true;
+    case Command::SystemSetup:
+      mOscillatorOn = command & 0x01;
+      return true;
+    case Command::KeyAddress:
+      if ((command & 0x0F) >= KeyRamSize) {
+        break;
+      }
+      // The key RAM is read only, trailing data is ignored
+      mKeyPointer = true;
+      mPointer = command & 0x0F;
+      return true;
+    case Command::DisplaySetup:
+      mDisplayOn = command & 0x01;
+      mBlink = static_cast<Blink>((command >> 1) & 0x03);
+      return true;
+    case Command::Dimming:
+      mBrightness = command & 0x0F;
+      return true;
+    default:
+      break;
+  }
+  ++mInvalidCommands;
+  return true;
+}
+
+bool SimulatedHT16K33::OnRead(uint8_t* aBuffer, const size_t aSize) {
+  const auto ram = mKeyPointer ? mKeyRam : mDisplayRam;
+  const auto ramSize = mKeyPointer ? KeyRamSize : DisplayRamSize;
+  for (size_t i = 0; i < aSize; ++i) {
+    aBuffer[i] = ram[mPointer];
+    mPointer = (mPointer + 1) % ramSize;
+  }
+  return true;
+}
+
+void SimulatedHT16K33::SetKeyRam(const uint8_t* aKeys) {
+  std::copy(aKeys, aKeys + KeyRamSize, mKeyRam);
+}
+}  // namespace I2C
@@ -0,0 +1,53 @@
+/**
+ * @file SimulatedI2CBus.cpp
+ * @author Zach Hannum
+ * @brief
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "SimulatedI2CBus.hpp"
+
+namespace I2C {
+SimulatedI2CBus::SimulatedI2CBus(SimulatedI2CDevice& aDevice,
+                                 const uint32_t aClockHz)
+    : mDevice(aDevice), mClockHz(aClockHz) {}
+
+bool SimulatedI2CBus::Write(const uint8_t* aData, const size_t aSize) {
+  if (aSize == 0) return false;
+
+  if (mFailWrites > 0) {
+    // The transaction ends after the NACKed address byte
+    --mFailWrites;
+    Charge(0);
+    return false;
+  }
+  Charge(aSize);
+  return mDevice.OnWrite(aData, aSize);
+}
+
+bool SimulatedI2CBus::Read(uint8_t* aBuffer, const size_t aSize) {
+  if (aSize == 0) return false;
+
+  Charge(aSize);
+  return mDevice.OnRead(aBuffer, aSize);
+}
+
+SimulatedI2CStats SimulatedI2CBus::GetStats() const { return mStats; }
+
+void SimulatedI2CBus::ResetStats() { mStats = SimulatedI2CStats{}; }
+
+void SimulatedI2CBus::FailNextWrites(const uint32_t aCount) {
+  mFailWrites = aCount;
+}
+
+void SimulatedI2CBus::Charge(const size_t aSize) {
+  // START, address byte, data bytes, STOP
+  const uint64_t bits = 1 + BitsPerByte * (1 + aSize) + 1;
+  ++mStats.mTransactions;
+  mStats.mBytes += 1 + aSize;
+  mStats.mBits += bits;
+  mStats.mBusTime += std::chrono::nanoseconds(bits * 1000000000 / mClockHz);
+}
+}  // namespace I2C
@@ -16,11 +16,13 @@
 #include <memory>
 #include <thread>
 
+#include "AsyncI2CBus.hpp"
 #include "ClockEvent.hpp"
-#include "EspI2CBus.hpp"
+#include "EspI2CBusManager.hpp"
 #include "Event.hpp"
 #include "EventDispatcher.hpp"
 #include "EventQueue.hpp"
+#include "EventScheduler.hpp"
 #include "HT16K33ClockDisplay.hpp"
 #include "SystemClock.hpp"
 #include "app_server.hpp"
@@ -35,6 +37,11 @@
 #include "freertos/task.h"
 #include "nvs_flash.h"
 #include "protocol_examples_common.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_EVENTS_CALLBACK_BENCH
+#include "CallbackBench.hpp"
+#endif
 
 static const char *TAG = "app_main";
 
@@ -46,20 +53,37 @@ void time_sync_notification_cb(struct timeval *tv) {
 #define INET6_ADDRSTRLEN 48
 #endif
 
-void app_clock(Events::EventDispatcher &aEventDispatcher) {
+void app_clock(Events::EventDispatcher &aEventDispatcher,
+               Events::EventScheduler &aScheduler) {
   using namespace Clocks;
-  SystemClock clock;
+  static SystemClock clock;
   clock.SetTz("EST5EDT");
   if (!clock.IsTimeSet()) {
     clock.Initialize();
   }
-  while (1) {
-    if (clock.IsTimeSet()) {
-      aEventDispatcher.Dispatch(
-          std::make_unique<Clocks::ClockEvent>(clock.GetLocalTime()));
-    }
-    vTaskDelay(500 / portTICK_PERIOD_MS);
+  if (!clock.IsTimeSet()) {
+    return;
   }
+  // The display shows hours and minutes, so publish the time now and then
+  // once per minute change instead of polling. The local time is converted
+  // here once, so listeners never call localtime.
+  auto publish = [&aEventDispatcher](time_t aNow) {
+    const auto status = aEventDispatcher.Dispatch<Clocks::ClockEvent>(
+        aNow, clock.ToLocalTime(aNow));
+    // A full queue drops the update, the display then shows the previous
+    // minute until the next one
+    if (status != Events::DispatchStatus::Queued &&
+        status != Events::DispatchStatus::Conflated) {
+      ESP_LOGW(TAG, "Clock update not queued, status %d",
+               static_cast<int>(status));
+    }
+  };
+  publish(clock.GetLocalTime());
+  // The timer runs on the steady clock and may fire a few milliseconds either
+  // side of the wall-clock boundary, so publish the boundary it was meant
+  // for rather than a time that can still read the previous minute
+  aScheduler.ScheduleAtNextMinute(
+      [publish] { publish((clock.GetLocalTime() + 30) / 60 * 60); }, true);
 }
 
 void app_log(Events::EventDispatcher &aEventDispatcher) {
@@ -76,41 +100,56 @@ void app_clock_display(Events::EventDispatcher &aEventDispatcher) {
                        .master = {
                            400000,
                        }};
-  I2C::EspI2CBus i2cBus(conf, 0x70, 0);
-  Clocks::HT16K33ClockDisplay clockDisplay(i2cBus);
-  aEventDispatcher.Listen(
-      Clocks::ClockEvent::Id, [&clockDisplay](Events::Event &aEvent) {
-        try {
-          auto event = dynamic_cast<Clocks::ClockEvent &>(aEvent);
-          auto now = event.GetTime();
-          const auto local = localtime(&now);
-          if(local->tm_hour < 7 || local->tm_hour > 21) {
-            clockDisplay.SetBrightness(0x0);
-          }
-          else {
-            clockDisplay.SetBrightness(0xF);
-          }
-          clockDisplay.SetTime(now);
-        } catch (const std::bad_cast &e) {
-          ESP_LOGI(TAG, "Unexpected event type %s", e.what());
+  // The manager owns the port, other devices on it get their own handles
+  auto &i2cManager = I2C::EspI2CBusManager::Instance();
+  if (!i2cManager.Install(I2C_NUM_0, conf)) {
+    ESP_LOGE(CLOCK_DISPLAY, "Failed to install I2C port %d", I2C_NUM_0);
+    return;
+  }
+  // Static so the display outlives this function, no task is kept around
+  // just to own it
+  static auto i2cBus = i2cManager.GetDevice(I2C_NUM_0, 0x70);
+  // The bus worker runs the I2C transfers, so updating the display never
+  // blocks the event loop thread
+  static I2C::AsyncI2CBus i2cWorker;
+  static I2C::AsyncI2CDevice displayDevice(i2cWorker, i2cBus, true);
+  static Clocks::HT16K33ClockDisplay clockDisplay(displayDevice);
+  // Queued writes report no result to the display, so when one fails the
+  // next frame resends the display setup, brightness and every digit
+  i2cWorker.SetFailureHandler([](I2C::I2CBus &aDevice) {
+    if (&aDevice == &i2cBus) {
+      clockDisplay.Invalidate();
+    }
+  });
+  aEventDispatcher.Listen<Clocks::ClockEvent>(
+      [](const Clocks::ClockEvent &aEvent) {
+        const auto &local = aEvent.GetLocalTime();
+        if (local.mHour < 7 || local.mHour > 21) {
+          clockDisplay.SetBrightness(0x0);
+        } else {
+          clockDisplay.SetBrightness(0xF);
         }
+        clockDisplay.SetTime(local);
       });
-  while (1) {
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-  }
 }
 
 extern "C" void app_main(void) {
+#ifdef CONFIG_EVENTS_CALLBACK_BENCH
+  // The host callback benchmark on the target, before anything else runs
+  Bench::RunCallbacks(CONFIG_EVENTS_CALLBACK_BENCH_REGISTRATIONS,
+                      CONFIG_EVENTS_CALLBACK_BENCH_CALLS);
+#endif
   ESP_ERROR_CHECK(nvs_flash_init());
   ESP_ERROR_CHECK(esp_netif_init());
   ESP_ERROR_CHECK(esp_event_loop_create_default());
 
   Events::EventQueue eventQueue;
   Events::EventDispatcher eventDispatcher(eventQueue);
+  // Drives all periodic work from one sleeping thread
+  Events::EventScheduler scheduler;
 
   auto log_thread = std::thread(app_log, std::ref(eventDispatcher));
-  auto clock_display_thread =
-      std::thread(app_clock_display, std::ref(eventDispatcher));
+  app_clock_display(eventDispatcher);
 
   /* This helper function configures Wi-Fi or Ethernet, as selected in
    * menuconfig. Read "Establishing Wi-Fi or Ethernet Connection" section in
@@ -118,12 +157,12 @@ extern "C" void app_main(void) {
    */
   ESP_ERROR_CHECK(example_connect());
 
-  auto clock_thread = std::thread(app_clock, std::ref(eventDispatcher));
+  // Waiting for SNTP can take a while, set up the clock without holding up
+  // the event loop
+  std::thread(app_clock, std::ref(eventDispatcher), std::ref(scheduler))
+      .detach();
   auto server_thread = std::thread(app_server, std::ref(eventDispatcher));
 
   // Process event queue
-  while (true) {
-    eventQueue.Pop();
-    vTaskDelay(10 / portTICK_PERIOD_MS);
-  }
+  eventQueue.RunLoop();
 }